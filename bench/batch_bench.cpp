@@ -0,0 +1,141 @@
+#include <string>
+
+#include "bench.h"
+#include "postfix.h"
+#include "batch.h"
+#include "shapes.h"
+
+namespace postfix::bench {
+
+namespace {
+
+struct row_t {
+    double x;
+    int id;
+    double y;
+};
+
+} // namespace
+
+// Row by row evaluation versus block kernels of every instruction set,
+// reading columns and fields of array of structs
+void batch_bench() {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+    converter.add_variable("y");
+
+    postfix_expr_t expr = converter.convert("(x * 1.5 + y) * (x - 2.25) / (y * y + 1) - x * 3");
+
+    const int num_rows = 4096;
+    util::vector<double> xs, ys, results(num_rows);
+    util::vector<row_t> rows;
+    for(int r = 0; r < num_rows; ++r) {
+        xs.push_back(r * 0.001);
+        ys.push_back(1 - r * 0.002);
+
+        row_t row = { xs[r], r, ys[r] };
+        rows.push_back(row);
+    }
+    const double *columns[] = { xs.begin(), ys.begin() };
+    simd::binding_t bindings[] = {
+        simd::binding_t::field(rows.begin(), &row_t::x),
+        simd::binding_t::field(rows.begin(), &row_t::y)
+    };
+    std::string suffix = " [" + std::to_string(num_rows) + " rows]";
+
+    report("evaluate_at (switch)" + suffix, measure_ns([&] {
+        for(int r = 0; r < num_rows; ++r) {
+            double row[] = { xs[r], ys[r] };
+            results[r] = expr.evaluate_at(row);
+        }
+        do_not_optimize(results[num_rows - 1]);
+    }));
+
+    const simd::isa_t isas[] = { simd::isa_t::scalar, simd::isa_t::sse2, simd::isa_t::avx2, simd::isa_t::avx512 };
+    for(simd::isa_t isa : isas) {
+        if(!simd::isa_supported(isa))
+            continue;
+
+        simd::batch_program_t batch(expr.get_program(), isa);
+        util::vector<double> scratch(batch.get_scratch_size());
+        report(std::string("evaluate_batch (") + simd::isa_name(isa) + ")" + suffix, measure_ns([&] {
+            batch.run(columns, num_rows, results.begin(), scratch.begin());
+            do_not_optimize(results[num_rows - 1]);
+        }));
+        report(std::string("evaluate_batch (") + simd::isa_name(isa) + ", strided)" + suffix, measure_ns([&] {
+            batch.run(bindings, num_rows, results.begin(), scratch.begin());
+            do_not_optimize(results[num_rows - 1]);
+        }));
+    }
+}
+
+// Expressions of the same shape: one by one versus lanes of shape_set_t
+void shapes_bench() {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+
+    const int num_exprs = 10000;
+    util::vector<postfix_expr_t> exprs;
+    for(int i = 0; i < num_exprs; ++i) {
+        std::string a = std::to_string(i % 97 + 1), b = std::to_string(i % 13);
+        exprs.push_back(converter.convert("(" + a + " * x + " + b + ") / (x + " + b + ".5)"));
+    }
+
+    double x = 0.75;
+    util::vector<double> results(num_exprs);
+    std::string suffix = " [" + std::to_string(num_exprs) + " expressions]";
+
+    report("evaluate_at (switch)" + suffix, measure_ns([&] {
+        for(int i = 0; i < num_exprs; ++i)
+            results[i] = exprs[i].evaluate_at(&x);
+        do_not_optimize(results[num_exprs - 1]);
+    }));
+
+    const simd::isa_t isas[] = { simd::isa_t::scalar, simd::isa_t::sse2, simd::isa_t::avx2, simd::isa_t::avx512 };
+    for(simd::isa_t isa : isas) {
+        if(!simd::isa_supported(isa))
+            continue;
+
+        simd::shape_set_t set(isa);
+        for(int i = 0; i < num_exprs; ++i)
+            set.add(exprs[i].get_program());
+
+        report(std::string("evaluate_all (") + simd::isa_name(isa) + ")" + suffix, measure_ns([&] {
+            set.evaluate_all(results.begin(), &x);
+            do_not_optimize(results[num_exprs - 1]);
+        }));
+    }
+}
+
+// Separately allocated expressions versus single packed program set
+void program_set_bench() {
+    // keep whole programs, which would be folded into constants otherwise
+    postfix_converter_t converter;
+    compile_options_t options;
+    options.constant_folding = false;
+    converter.set_options(options);
+
+    const int num_exprs = 50000;
+    util::vector<postfix_expr_t> exprs;
+    bytecode::program_set_t set;
+    for(int i = 0; i < num_exprs; ++i) {
+        exprs.push_back(converter.convert(make_expression(10 + i % 7) + " * " + std::to_string(i)));
+        set.add(exprs[i].get_program());
+    }
+
+    util::vector<double> results(num_exprs);
+    std::string suffix = " [" + std::to_string(num_exprs) + " expressions]";
+
+    report("evaluate (switch)" + suffix, measure_ns([&] {
+        for(int i = 0; i < num_exprs; ++i)
+            results[i] = exprs[i].evaluate();
+        do_not_optimize(results[num_exprs - 1]);
+    }));
+
+    report("program_set_t::evaluate_all" + suffix, measure_ns([&] {
+        set.evaluate_all(results.begin());
+        do_not_optimize(results[num_exprs - 1]);
+    }));
+}
+
+} // namespace postfix::bench
@@ -0,0 +1,54 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * Minimal benchmarking harness
+ *      Each benchmark group is a function, registered in bench_main.cpp
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace postfix::bench {
+
+// Prevent compiler from optimizing away computed value
+inline void do_not_optimize(double val) {
+    asm volatile("" : : "r,m"(val) : "memory");
+}
+
+// Run [func] repeatedly for at least [min_time_ms]
+// Returns average time of 1 call in nanoseconds
+template<typename Func>
+double measure_ns(Func func, double min_time_ms = 200) {
+    using clock = std::chrono::steady_clock;
+
+    // warm up
+    func();
+
+    long iters = 1;
+    while(true) {
+        clock::time_point start = clock::now();
+        for(long i = 0; i < iters; ++i)
+            func();
+        double elapsed_ns =
+            std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+        if(elapsed_ns >= min_time_ms * 1e6)
+            return elapsed_ns / iters;
+
+        iters *= 2;
+    }
+}
+
+inline void report(const std::string& name, double ns_per_call) {
+    std::printf("%-56s %14.1f ns\n", name.c_str(), ns_per_call);
+}
+
+// Builds expression of approximately [num_tokens] tokens
+// mixing all binary operators and parenthesis
+std::string make_expression(int num_tokens);
+
+} // namespace postfix::bench
+
+#endif
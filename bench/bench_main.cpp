@@ -0,0 +1,77 @@
+#include <cstring>
+#include <string>
+
+#include "bench.h"
+
+namespace postfix::bench {
+
+// Benchmark groups
+void evaluate_bench();
+void superinstructions_bench();
+void batch_bench();
+void shapes_bench();
+void program_set_bench();
+void parallel_bench();
+void subtrees_bench();
+void convert_parallel_bench();
+void operator_match_bench();
+void lexer_bench();
+void number_parser_bench();
+void convert_range_bench();
+void stream_bench();
+
+std::string make_expression(int num_tokens) {
+    static const char *ops[] = { " + ", " * ", " - ", " / " };
+
+    std::string res = "1.5";
+    int tokens = 1;
+    for(int i = 0; tokens < num_tokens; ++i) {
+        if(i % 7 == 6) { /*nested group: ( num op num ), 5 tokens*/
+            res += ops[i % 4];
+            res += "(2.25 - 0.5)";
+            tokens += 6;
+        } else {
+            res += ops[i % 4];
+            res += std::to_string(i % 9 + 1);
+            tokens += 2;
+        }
+    }
+
+    return res;
+}
+
+} // namespace postfix::bench
+
+struct bench_group {
+    const char *name;
+    void (*func)();
+};
+
+// Usage: calculator_bench [group_name_filter]
+int main(int argc, char *argv[]) {
+    bench_group groups[] = {
+        { "evaluate", postfix::bench::evaluate_bench },
+        { "superinstructions", postfix::bench::superinstructions_bench },
+        { "batch", postfix::bench::batch_bench },
+        { "shapes", postfix::bench::shapes_bench },
+        { "program_set", postfix::bench::program_set_bench },
+        { "parallel", postfix::bench::parallel_bench },
+        { "subtrees", postfix::bench::subtrees_bench },
+        { "convert_parallel", postfix::bench::convert_parallel_bench },
+        { "operator_match", postfix::bench::operator_match_bench },
+        { "lexer", postfix::bench::lexer_bench },
+        { "number_parser", postfix::bench::number_parser_bench },
+        { "convert_range", postfix::bench::convert_range_bench },
+        { "stream", postfix::bench::stream_bench }
+    };
+
+    for(const bench_group& group : groups) {
+        if(argc > 1 && std::strstr(group.name, argv[1]) == NULL)
+            continue;
+
+        std::printf("== %s\n", group.name);
+        group.func();
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <string>
+
+#include "bench.h"
+#include "postfix.h"
+
+namespace postfix::bench {
+
+// Token walk (virtual calls through token_t) versus bytecode interpreters
+void evaluate_bench() {
+    postfix_converter_t converter;
+    const int sizes[] = { 10, 100, 10000 };
+
+    for(int size : sizes) {
+        postfix_expr_t expr = converter.convert(make_expression(size));
+        std::string suffix = " [" + std::to_string(size) + " tokens]";
+
+        report("evaluate_tokens" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate_tokens());
+        }));
+
+        report("evaluate (switch)" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate());
+        }));
+
+        expr.set_backend(backend_t::threaded);
+        report("evaluate (threaded)" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate());
+        }));
+
+        expr.set_backend(backend_t::register_vm);
+        report("evaluate (register_vm)" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate());
+        }));
+
+        expr.set_backend(backend_t::jit);
+        report("evaluate (jit)" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate());
+        }));
+
+        expr.set_backend(backend_t::slp);
+        report("evaluate (slp)" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate());
+        }));
+    }
+}
+
+} // namespace postfix::bench
@@ -0,0 +1,185 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "bench.h"
+#include "lexer.h"
+#include "number_parser.h"
+#include "postfix.h"
+#include "stream.h"
+
+namespace postfix::bench {
+
+// Recognition of operators by converter, which knows a few hundred functions
+// Input is a stream of function names and operators, e.g. "f17 + f203 * f5 ..."
+void operator_match_bench() {
+    const int num_functions = 300;
+
+    util::vector<token_t> tokens = {
+        builder::left_parenthesis(),
+        builder::right_paranthesis(),
+        builder::comma(),
+        builder::plus(),
+        builder::plus_unary(),
+        builder::minus(),
+        builder::minus_unary(),
+        builder::multiplication(),
+        builder::division(),
+        builder::exp(),
+        builder::fma()
+    };
+    // named tokens stand for functions: only their names matter to recognition
+    for(int i = 0; i < num_functions; ++i)
+        tokens.push_back(builder::variable("func_" + std::to_string(i * 7919 % 1000), i));
+
+    detail::postfix_converter_impl_t impl(tokens);
+
+    static const char *ops[] = { " + ", " * ", " - ", " / ", ", " };
+    std::string input = "func_0";
+    int num_tokens = 1;
+    for(int i = 1; num_tokens < 100000; ++i) {
+        input += ops[i % 5];
+        input += "func_" + std::to_string(i * 31 % num_functions * 7919 % 1000);
+        num_tokens += 2;
+    }
+
+    util::vector<token_t> candidates;
+    std::string suffix = " [" + std::to_string(num_functions) + " functions, "
+        + std::to_string(num_tokens) + " tokens]";
+
+    report("get_token_candidates" + suffix, measure_ns([&] {
+        const char *beg = input.data(), *end = input.data() + input.size();
+        int found = 0;
+        while(beg != end) {
+            candidates.clear();
+            beg = impl.get_token_candidates(beg, end, candidates);
+            found += candidates.size();
+        }
+        do_not_optimize(found);
+    }));
+}
+
+// Scanning of whitespace padding and long numeric literals: scalar versus vector scans
+void lexer_bench() {
+    const int size = 1 << 24;
+    std::string padding(size, ' ');
+    padding[size - 1] = 'x';
+
+    const simd::isa_t isas[] = { simd::isa_t::scalar, simd::isa_t::sse2, simd::isa_t::avx2 };
+    for(simd::isa_t isa : isas) {
+        if(!simd::isa_supported(isa))
+            continue;
+
+        report(std::string("skip spaces (") + simd::isa_name(isa) + ") [16 MiB]", measure_ns([&] {
+            const char *beg = padding.data();
+            do_not_optimize(lexer::skip(beg, beg + size, lexer::space, isa) - beg);
+        }));
+    }
+
+    // heavily padded expression of long literals
+    postfix_converter_t converter;
+    std::string input = "0";
+    for(int i = 0; i < 1000; ++i)
+        input += std::string(200, ' ') + "+\n" + std::string(100, '\t') + "000000000000000000000000000" + std::to_string(i) + ".25";
+
+    report("convert padded input [" + std::to_string(input.size()) + " chars]", measure_ns([&] {
+        do_not_optimize(converter.convert(input).evaluate());
+    }));
+}
+
+// Numeric literals: parse_number versus strtod
+void number_parser_bench() {
+    std::mt19937_64 rng(42);
+
+    // shortest round-trip forms of random doubles of moderate magnitude, and short literals
+    struct literal_set_t {
+        const char *name;
+        util::vector<std::string> literals;
+    } sets[2] = { { "17 digits", {} }, { "short", {} } };
+
+    for(int i = 0; i < 10000; ++i) {
+        char buf[64];
+        double val = std::ldexp((double) (rng() >> 11), (int) (rng() % 200) - 100 - 53);
+        std::snprintf(buf, sizeof(buf), "%.17g", val);
+        sets[0].literals.push_back(buf);
+        std::snprintf(buf, sizeof(buf), "%d.%d", (int) (rng() % 1000), (int) (rng() % 100));
+        sets[1].literals.push_back(buf);
+    }
+
+    for(const literal_set_t& set : sets) {
+        const util::vector<std::string>& literals = set.literals;
+        std::string suffix = std::string(" [") + set.name + ", " + std::to_string(literals.size()) + " literals]";
+
+        report("parse_number" + suffix, measure_ns([&] {
+            double sum = 0, val = 0;
+            for(int i = 0; i < literals.size(); ++i) {
+                lexer::parse_number(literals[i].data(), literals[i].data() + literals[i].size(), val);
+                sum += val;
+            }
+            do_not_optimize(sum);
+        }));
+
+        report("strtod" + suffix, measure_ns([&] {
+            double sum = 0;
+            for(int i = 0; i < literals.size(); ++i)
+                sum += std::strtod(literals[i].c_str(), NULL);
+            do_not_optimize(sum);
+        }));
+    }
+}
+
+// Conversion of lines of large buffer: string per line versus range of buffer
+void convert_range_bench() {
+    postfix_converter_t converter;
+
+    std::string buffer;
+    util::vector<int> line_ends;
+    for(int i = 0; i < 1000; ++i) {
+        buffer += make_expression(i % 10 == 0 ? 200 : 20);
+        line_ends.push_back(buffer.size());
+        buffer += '\n';
+    }
+    std::string suffix = " [" + std::to_string(line_ends.size()) + " lines]";
+
+    report("convert(std::string(line))" + suffix, measure_ns([&] {
+        double sum = 0;
+        for(int i = 0, beg = 0; i < line_ends.size(); beg = line_ends[i++] + 1)
+            sum += converter.convert(std::string(buffer, beg, line_ends[i] - beg)).evaluate();
+        do_not_optimize(sum);
+    }));
+
+    report("convert(beg, end)" + suffix, measure_ns([&] {
+        double sum = 0;
+        for(int i = 0, beg = 0; i < line_ends.size(); beg = line_ends[i++] + 1)
+            sum += converter.convert(buffer.data() + beg, buffer.data() + line_ends[i]).evaluate();
+        do_not_optimize(sum);
+    }));
+}
+
+// Huge expression, arriving in chunks: whole text converted at once versus streaming conversion,
+// which evaluates tokens as they leave converter
+void stream_bench() {
+    postfix_converter_t converter;
+    std::string input = make_expression(1 << 20);
+    const int chunk_size = 1 << 16;
+    std::string suffix = " [" + std::to_string(input.size()) + " chars]";
+
+    report("convert + evaluate_tokens" + suffix, measure_ns([&] {
+        do_not_optimize(converter.convert(input).evaluate_tokens());
+    }));
+
+    util::stack<double> values;
+    stream_converter_t stream(converter, [&](token_t& token) { token.calc_process(values); });
+    report("stream_converter_t (64 KiB chunks)" + suffix, measure_ns([&] {
+        for(std::size_t pos = 0; pos < input.size(); pos += chunk_size)
+            stream.feed(std::string_view(input).substr(pos, chunk_size));
+        stream.finish();
+
+        do_not_optimize(values.peek());
+        values.pop();
+    }));
+}
+
+} // namespace postfix::bench
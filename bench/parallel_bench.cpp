@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "bench.h"
+#include "parallel.h"
+
+namespace postfix::bench {
+
+// Batch conversion and evaluation: serial loop versus thread pools of growing size
+void parallel_bench() {
+    postfix_converter_t converter;
+
+    // skewed lengths: every 64th input is 100 times longer
+    const int num_inputs = 4096;
+    util::vector<std::string> inputs;
+    for(int i = 0; i < num_inputs; ++i)
+        inputs.push_back(make_expression(i % 64 == 0 ? 2000 : 20));
+
+    util::vector<double> results(num_inputs);
+    std::string suffix = " [" + std::to_string(num_inputs) + " inputs]";
+
+    report("convert + evaluate (serial)" + suffix, measure_ns([&] {
+        for(int i = 0; i < num_inputs; ++i)
+            results[i] = converter.convert(inputs[i]).evaluate();
+        do_not_optimize(results[num_inputs - 1]);
+    }));
+
+    int max_workers = std::max(1, (int) std::thread::hardware_concurrency());
+    for(int num_workers = 1; num_workers <= max_workers; num_workers *= 2) {
+        parallel::thread_pool_t pool(num_workers);
+        report("convert_and_evaluate (" + std::to_string(num_workers) + " workers)" + suffix, measure_ns([&] {
+            parallel::convert_and_evaluate(pool, converter, inputs.begin(), num_inputs, results.begin());
+            do_not_optimize(results[num_inputs - 1]);
+        }));
+    }
+}
+
+namespace {
+
+// Balanced tree of [2^depth] distinct leaves x + k
+std::string make_tree(int depth, int& leaf) {
+    static const char *ops[] = { " + ", " * ", " - ", " / " };
+
+    if(depth == 0)
+        return "(x + " + std::to_string(++leaf) + ")";
+
+    std::string left = make_tree(depth - 1, leaf);
+    return "(" + left + ops[depth % 4] + make_tree(depth - 1, leaf) + ")";
+}
+
+} // namespace
+
+// Single huge expression: serial evaluation versus independent subtrees on thread pools
+void subtrees_bench() {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+
+    int leaf = 0;
+    postfix_expr_t expr = converter.convert(make_tree(18, leaf));
+    std::string suffix = " [" + std::to_string(expr.get_program().get_code().size()) + " instructions]";
+
+    double x = 0.5;
+    report("evaluate_at (switch)" + suffix, measure_ns([&] {
+        do_not_optimize(expr.evaluate_at(&x));
+    }));
+
+    int max_workers = std::max(1, (int) std::thread::hardware_concurrency());
+    for(int num_workers = 1; num_workers <= max_workers; num_workers *= 2) {
+        parallel::thread_pool_t pool(num_workers);
+        report("evaluate_parallel (" + std::to_string(num_workers) + " workers)" + suffix, measure_ns([&] {
+            do_not_optimize(expr.evaluate_parallel(pool, &x));
+        }));
+    }
+}
+
+// Conversion of single huge expression: serial versus chunks on thread pools
+// Compilation of result is serial in both cases
+void convert_parallel_bench() {
+    postfix_converter_t converter;
+    std::string input = make_expression(1 << 20);
+    std::string suffix = " [" + std::to_string(input.size()) + " chars]";
+
+    report("convert (serial)" + suffix, measure_ns([&] {
+        do_not_optimize(converter.convert(input).evaluate());
+    }));
+
+    int max_workers = std::max(1, (int) std::thread::hardware_concurrency());
+    for(int num_workers = 1; num_workers <= max_workers; num_workers *= 2) {
+        parallel::thread_pool_t pool(num_workers);
+        report("convert_parallel (" + std::to_string(num_workers) + " workers)" + suffix, measure_ns([&] {
+            do_not_optimize(converter.convert_parallel(input, pool).evaluate());
+        }));
+    }
+}
+
+} // namespace postfix::bench
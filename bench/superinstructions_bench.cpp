@@ -0,0 +1,51 @@
+#include <string>
+
+#include "bench.h"
+#include "postfix.h"
+
+namespace postfix::bench {
+
+// Programs without superinstructions versus fused ones
+void superinstructions_bench() {
+    const int sizes[] = { 100, 10000 };
+    const backend_t backends[] = { backend_t::switch_dispatch, backend_t::threaded };
+    const char *backend_names[] = { "switch", "threaded" };
+
+    for(int size : sizes) {
+        std::string in = make_expression(size);
+
+        // set derived from the benchmarked expression itself
+        postfix_converter_t plain;
+        compile_options_t options;
+        options.superinstructions = bytecode::superinstruction_set_t::none();
+        plain.set_options(options);
+
+        bytecode::ngram_profiler_t profiler;
+        profiler.record(plain.convert(in).get_program());
+
+        postfix_converter_t fused;
+        options.superinstructions = profiler.select(4);
+        fused.set_options(options);
+
+        postfix_expr_t
+            plain_expr = plain.convert(in),
+            fused_expr = fused.convert(in);
+
+        for(int i = 0; i < 2; ++i) {
+            std::string suffix =
+                std::string(" (") + backend_names[i] + ") [" + std::to_string(size) + " tokens]";
+
+            plain_expr.set_backend(backends[i]);
+            report("no superinstructions" + suffix, measure_ns([&] {
+                do_not_optimize(plain_expr.evaluate());
+            }));
+
+            fused_expr.set_backend(backends[i]);
+            report("profiled superinstructions" + suffix, measure_ns([&] {
+                do_not_optimize(fused_expr.evaluate());
+            }));
+        }
+    }
+}
+
+} // namespace postfix::bench
@@ -6,7 +6,7 @@
 #include "postfix.h"
 
 
-int main(int argc, char *argv[]) {
+int main() {
 
     postfix::postfix_converter_t converter;
     postfix::postfix_expr_t expr;
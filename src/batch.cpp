@@ -0,0 +1,363 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+// Kernel is instantiated for every vector width and inlined into function,
+// compiled for corresponding instruction set
+#if defined(__GNUC__)
+#define BATCH_INLINE inline __attribute__((always_inline))
+// vectors are passed only between inlined functions, so ABI of wide vectors does not matter
+#pragma GCC diagnostic ignored "-Wpsabi"
+#else
+#define BATCH_INLINE inline
+#endif
+
+namespace postfix::simd {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+typedef bytecode::instruction_t instruction_t;
+
+const std::ptrdiff_t cache_line = 64;
+
+struct kernel_args_t {
+    const instruction_t *begin, *end;
+    const double *consts;   /*block_rows values per constant*/
+    int consts_stride;      /*values between constants of consecutive blocks, 0 if the same for all rows*/
+    const double *const *columns;   /*NULL, if variables are read through bindings*/
+    const binding_t *bindings;
+    int num_rows;
+    double *results;
+    double *stack;  /*block_rows values per slot*/
+    double *temps;
+};
+
+#if POSTFIX_HAS_SIMD
+// Vector types of GCC and Clang: operators apply lane by lane,
+// instructions are those of function, into which they are inlined
+typedef double vec2_t __attribute__((vector_size(16)));
+typedef double vec4_t __attribute__((vector_size(32)));
+typedef double vec8_t __attribute__((vector_size(64)));
+#endif
+
+// Lanes of [V], which is double for scalar kernel
+template<typename V>
+BATCH_INLINE V load(const double *src) {
+    V res;
+    std::memcpy(&res, src, sizeof(V));
+    return res;
+}
+
+template<typename V>
+BATCH_INLINE void store(double *dst, const V& value) {
+    std::memcpy(dst, &value, sizeof(V));
+}
+
+// Reads values of variable [var] of [num_rows] rows from [first_row] into [dst]
+BATCH_INLINE void load_rows(const kernel_args_t& args, int var, int first_row, int num_rows, double *dst) {
+    if(args.columns != NULL) {
+        std::memcpy(dst, args.columns[var] + first_row, num_rows * sizeof(double));
+        return;
+    }
+
+    const binding_t& binding = args.bindings[var];
+    const char *src = static_cast<const char *>(binding.base) + binding.offset + first_row * binding.stride;
+    if(binding.stride == sizeof(double)) {
+        std::memcpy(dst, src, num_rows * sizeof(double));
+        return;
+    }
+
+    // Rows are spread over memory: fields are read one by one
+    // (gather instructions are not faster than separate loads of doubles),
+    // while cache lines of next block are prefetched (prefetch never faults)
+#if defined(__GNUC__)
+    const std::ptrdiff_t span = num_rows * binding.stride;
+    for(std::ptrdiff_t line = 0; line < span; line += cache_line)
+        __builtin_prefetch(src + span + line);
+#endif
+
+    for(int r = 0; r < num_rows; ++r)
+        std::memcpy(dst + r, src + r * binding.stride, sizeof(double));
+}
+
+// Evaluates rows [first_row, first_row + num_rows) of block
+// Loops run over [rows] values: num_rows rounded up to multiple of W
+template<typename V, int W>
+BATCH_INLINE void execute_block(const kernel_args_t& args, int first_row, int num_rows) {
+    const int stride = batch_program_t::block_rows;
+    const int rows = (num_rows + W - 1) / W * W;
+
+    int depth = 0; /*number of blocks on stack*/
+#define BLOCK(i) (args.stack + (i) * stride)
+    const double *consts = args.consts + first_row / stride * args.consts_stride;
+#define CONST(i) (consts + (i) * stride)
+
+    for(const instruction_t *ip = args.begin; ip != args.end; ++ip) {
+        double *x = depth >= 2 ? BLOCK(depth - 2) : NULL; /*second from top*/
+        double *y = depth >= 1 ? BLOCK(depth - 1) : NULL; /*top*/
+
+        switch(ip->op) {
+        case op_t::push_const:
+            std::memcpy(BLOCK(depth), CONST(ip->arg), rows * sizeof(double));
+            ++depth;
+            break;
+        case op_t::load_var:
+            load_rows(args, ip->arg, first_row, num_rows, BLOCK(depth));
+            std::fill(BLOCK(depth) + num_rows, BLOCK(depth) + rows, 0.0);
+            ++depth;
+            break;
+
+        case op_t::add:
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(x + r) + load<V>(y + r));
+            --depth;
+            break;
+        case op_t::sub:
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(x + r) - load<V>(y + r));
+            --depth;
+            break;
+        case op_t::mul:
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(x + r) * load<V>(y + r));
+            --depth;
+            break;
+        case op_t::div:
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(x + r) / load<V>(y + r));
+            --depth;
+            break;
+        case op_t::rsub:
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(y + r) - load<V>(x + r));
+            --depth;
+            break;
+        case op_t::rdiv:
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(y + r) / load<V>(x + r));
+            --depth;
+            break;
+        case op_t::neg:
+            for(int r = 0; r < rows; r += W)
+                store(y + r, -load<V>(y + r));
+            break;
+
+        /*no vector form, rows are computed one by one*/
+        case op_t::pow:
+            for(int r = 0; r < rows; ++r)
+                x[r] = std::pow(x[r], y[r]);
+            --depth;
+            break;
+        case op_t::rpow:
+            for(int r = 0; r < rows; ++r)
+                x[r] = std::pow(y[r], x[r]);
+            --depth;
+            break;
+        case op_t::sqrt:
+            for(int r = 0; r < rows; ++r)
+                y[r] = bytecode::pow_half(y[r]);
+            break;
+        case op_t::fma: {
+            double *z = BLOCK(depth - 3);
+            for(int r = 0; r < rows; ++r)
+                z[r] = std::fma(z[r], x[r], y[r]);
+            depth -= 2;
+            break;
+        }
+
+        case op_t::dup:
+            std::memcpy(BLOCK(depth), y, rows * sizeof(double));
+            ++depth;
+            break;
+        case op_t::store_tmp:
+            std::memcpy(args.temps + ip->arg * stride, y, rows * sizeof(double));
+            break;
+        case op_t::load_tmp:
+            std::memcpy(BLOCK(depth), args.temps + ip->arg * stride, rows * sizeof(double));
+            ++depth;
+            break;
+
+        case op_t::add_imm: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; r += W)
+                store(y + r, load<V>(y + r) + load<V>(imm + r));
+            break;
+        }
+        case op_t::sub_imm: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; r += W)
+                store(y + r, load<V>(y + r) - load<V>(imm + r));
+            break;
+        }
+        case op_t::mul_imm: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; r += W)
+                store(y + r, load<V>(y + r) * load<V>(imm + r));
+            break;
+        }
+        case op_t::div_imm: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; r += W)
+                store(y + r, load<V>(y + r) / load<V>(imm + r));
+            break;
+        }
+        case op_t::pow_imm: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; ++r)
+                y[r] = std::pow(y[r], imm[r]);
+            break;
+        }
+        case op_t::mul_imm_add: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(x + r) + load<V>(y + r) * load<V>(imm + r));
+            --depth;
+            break;
+        }
+        case op_t::mul_imm_sub: {
+            const double *imm = CONST(ip->arg);
+            for(int r = 0; r < rows; r += W)
+                store(x + r, load<V>(x + r) - load<V>(y + r) * load<V>(imm + r));
+            --depth;
+            break;
+        }
+
+        case op_t::nop:
+        case op_t::halt:
+            break;
+        }
+    }
+
+    assert(depth == 1);
+    std::memcpy(args.results + first_row, BLOCK(0), num_rows * sizeof(double));
+#undef CONST
+#undef BLOCK
+}
+
+template<typename V, int W>
+BATCH_INLINE void execute_rows(const kernel_args_t& args) {
+    for(int first = 0; first < args.num_rows; first += batch_program_t::block_rows)
+        execute_block<V, W>(args, first, std::min(batch_program_t::block_rows, args.num_rows - first));
+}
+
+void run_scalar(const kernel_args_t& args) {
+    execute_rows<double, 1>(args);
+}
+
+#if POSTFIX_HAS_SIMD
+
+void run_sse2(const kernel_args_t& args) {
+    execute_rows<vec2_t, 2>(args);
+}
+
+__attribute__((target("avx2")))
+void run_avx2(const kernel_args_t& args) {
+    execute_rows<vec4_t, 4>(args);
+}
+
+__attribute__((target("avx512f")))
+void run_avx512(const kernel_args_t& args) {
+    execute_rows<vec8_t, 8>(args);
+}
+
+#endif
+
+} // namespace
+
+
+batch_program_t::batch_program_t(const bytecode::program_t& prog, isa_t new_isa):
+    max_depth(0),
+    num_temps(0),
+    isa(new_isa)
+{
+    assert(isa_supported(isa));
+    if(!prog.valid())
+        return;
+
+    code = prog.get_code();
+    constants = prog.get_constants();
+    max_depth = prog.get_max_depth();
+    num_temps = prog.get_num_temps();
+}
+
+void batch_program_t::run(
+    const double *const *columns,
+    int num_rows,
+    double *results,
+    double *scratch
+) const {
+    execute(broadcast_constants(scratch), 0, columns, NULL, num_rows, results, scratch);
+}
+
+void batch_program_t::run(
+    const binding_t *bindings,
+    int num_rows,
+    double *results,
+    double *scratch
+) const {
+    execute(broadcast_constants(scratch), 0, NULL, bindings, num_rows, results, scratch);
+}
+
+void batch_program_t::run(
+    const double *row_constants,
+    const binding_t *bindings,
+    int num_rows,
+    double *results,
+    double *scratch
+) const {
+    execute(row_constants, get_num_constants() * block_rows, NULL, bindings, num_rows, results, scratch);
+}
+
+const double *batch_program_t::broadcast_constants(double *scratch) const {
+    double *blocks = scratch + (max_depth + num_temps) * block_rows;
+    for(int c = 0; c < constants.size(); ++c)
+        std::fill(blocks + c * block_rows, blocks + (c + 1) * block_rows, constants[c]);
+
+    return blocks;
+}
+
+void batch_program_t::execute(
+    const double *consts,
+    int consts_stride,
+    const double *const *columns,
+    const binding_t *bindings,
+    int num_rows,
+    double *results,
+    double *scratch
+) const {
+    assert(!empty());
+
+    kernel_args_t args = {
+        code.begin(), code.end(),
+        consts,
+        consts_stride,
+        columns,
+        bindings,
+        num_rows,
+        results,
+        scratch,
+        scratch + max_depth * block_rows
+    };
+    switch(isa) {
+#if POSTFIX_HAS_SIMD
+    case isa_t::avx512:
+        run_avx512(args);
+        break;
+    case isa_t::avx2:
+        run_avx2(args);
+        break;
+    case isa_t::sse2:
+        run_sse2(args);
+        break;
+#endif
+    default:
+        run_scalar(args);
+        break;
+    }
+}
+
+} // namespace postfix::simd
@@ -0,0 +1,126 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+/**
+ * Batch evaluation over rows of variables
+ *      Structure-of-arrays input: column of values per variable
+ *      Array-of-structs input: strided binding of variable to field of user's struct
+ *      Block interpreter, every instruction is applied to block of rows
+ *      Vector kernels (SSE2/AVX2/AVX-512), chosen at runtime, scalar fallback
+*/
+
+#include "bytecode.h"
+#include "simd.h"
+
+#include "util/vector.h"
+
+#include <cstddef>
+
+namespace postfix::simd {
+
+// Location of variable's values: value of row r is double at
+// (const char *) base + offset + r * stride
+// Binds variable to field of array of structs without copying it into column
+struct binding_t {
+    const void *base;
+    std::ptrdiff_t offset;  /*bytes*/
+    std::ptrdiff_t stride;  /*bytes between rows*/
+
+    // contiguous column of values
+    static binding_t column(const double *values) {
+        binding_t res = { values, 0, sizeof(double) };
+        return res;
+    }
+
+    // field [field] of structs in array [rows], e.g. binding_t::field(quotes, &quote_t::bid)
+    // [rows] must point to at least 1 struct
+    template<typename S>
+    static binding_t field(const S *rows, double S::*field) {
+        const S *first = rows;
+        binding_t res = {
+            rows,
+            reinterpret_cast<const char *>(&(first->*field)) - reinterpret_cast<const char *>(first),
+            sizeof(S)
+        };
+        return res;
+    }
+};
+
+// Form of program, which evaluates it over many rows at once
+// Rows are split into blocks; every stack slot (and temporary) holds values of whole block,
+// so that dispatch of instruction is paid once per block and its loop over rows
+// is performed by vector instructions: 4 rows per instruction with AVX2, 8 with AVX-512.
+// Operators without vector form (pow, sqrt, fma) loop over rows with scalar functions,
+// so every row is computed exactly as by bytecode::interpret
+class batch_program_t {
+public:
+    // rows in block, multiple of every vector width
+    static constexpr int block_rows = 64;
+
+    batch_program_t(): max_depth(0), num_temps(0), isa(isa_t::scalar) {}
+
+    // [isa] selects kernel; it must be supported by running CPU
+    explicit batch_program_t(const bytecode::program_t& prog, isa_t isa = native_isa());
+
+    bool empty() const {
+        return code.empty();
+    }
+
+    isa_t get_isa() const {
+        return isa;
+    }
+
+    int get_num_constants() const {
+        return constants.size();
+    }
+
+    // number of values required by run
+    int get_scratch_size() const {
+        return (max_depth + num_temps + get_num_constants()) * block_rows;
+    }
+
+    // results[row] = value of program, where variable v is columns[v][row], for every row < [num_rows]
+    // [scratch] must hold at least get_scratch_size() values
+    void run(const double *const *columns, int num_rows, double *results, double *scratch) const;
+
+    // results[row] = value of program, where variable v is read through bindings[v]
+    // Strided values are read in place, upcoming rows are prefetched
+    void run(const binding_t *bindings, int num_rows, double *results, double *scratch) const;
+
+    // The same, constants of program being given for every row (see shape_set_t):
+    // constant c of row r is row_constants[(r / block_rows * get_num_constants() + c) * block_rows + r % block_rows]
+    void run(
+        const double *row_constants,
+        const binding_t *bindings,
+        int num_rows,
+        double *results,
+        double *scratch
+    ) const;
+
+private:
+    util::vector<bytecode::instruction_t> code;
+    util::vector<double> constants;
+
+    int max_depth;
+    int num_temps; /*blocks of temporaries follow blocks of stack, then blocks of constants*/
+    isa_t isa;
+
+    // fills blocks of constants in [scratch], the same for every row
+    const double *broadcast_constants(double *scratch) const;
+
+    // constant c of block b is consts[b * consts_stride + c * block_rows]
+    // variables are read from [columns], if it is not NULL, otherwise through [bindings]
+    void execute(
+        const double *consts,
+        int consts_stride,
+        const double *const *columns,
+        const binding_t *bindings,
+        int num_rows,
+        double *results,
+        double *scratch
+    ) const;
+};
+
+} // namespace postfix::simd
+
+#endif
@@ -0,0 +1,678 @@
+#include "bytecode.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace postfix::bytecode {
+
+/* program_t */
+
+void program_t::push_constant(double val) {
+    instruction_t instr = { opcode_t::push_const, (std::uint32_t) constants.size() };
+    constants.push_back(val);
+    code.push_back(instr);
+
+    ++cur_depth;
+    max_depth = std::max(max_depth, cur_depth);
+}
+
+void program_t::apply(opcode_t op, int num_operands, const std::string& name) {
+    if(!is_valid)
+        return;
+
+    if(cur_depth < num_operands) {
+        // same message as token_strategies::do_calc_apply
+        invalidate("do_calc_apply: operator " + name + " does not have enough operands");
+        return;
+    }
+
+    cur_depth -= num_operands - 1;
+    max_depth = std::max(max_depth, cur_depth);
+    max_num_operands = std::max(max_num_operands, num_operands);
+
+    if(op == opcode_t::nop)
+        return;
+
+    instruction_t instr = { op, 0 };
+    code.push_back(instr);
+}
+
+void program_t::apply_imm(
+    opcode_t op,
+    double imm,
+    int num_operands,
+    const std::string& name
+) {
+    assert(has_immediate(op));
+    std::uint32_t imm_idx = (std::uint32_t) constants.size();
+
+    apply(op, num_operands, name);
+    if(!is_valid)
+        return;
+
+    constants.push_back(imm);
+    code[code.size() - 1].arg = imm_idx;
+}
+
+void program_t::dup() {
+    if(!is_valid)
+        return;
+
+    if(cur_depth < 1) {
+        invalidate("program_t::dup: stack is empty");
+        return;
+    }
+
+    instruction_t instr = { opcode_t::dup, 0 };
+    code.push_back(instr);
+
+    ++cur_depth;
+    max_depth = std::max(max_depth, cur_depth);
+}
+
+void program_t::store_temp(std::uint32_t idx) {
+    if(!is_valid)
+        return;
+
+    if(cur_depth < 1) {
+        invalidate("program_t::store_temp: stack is empty");
+        return;
+    }
+
+    instruction_t instr = { opcode_t::store_tmp, idx };
+    code.push_back(instr);
+
+    num_temps = std::max(num_temps, (int) idx + 1);
+}
+
+void program_t::load_temp(std::uint32_t idx) {
+    if(!is_valid)
+        return;
+
+    if((int) idx >= num_temps) {
+        invalidate("program_t::load_temp: temporary is not stored");
+        return;
+    }
+
+    instruction_t instr = { opcode_t::load_tmp, idx };
+    code.push_back(instr);
+
+    ++cur_depth;
+    max_depth = std::max(max_depth, cur_depth);
+}
+
+void program_t::load_var(std::uint32_t idx) {
+    if(!is_valid)
+        return;
+
+    instruction_t instr = { opcode_t::load_var, idx };
+    code.push_back(instr);
+
+    num_vars = std::max(num_vars, (int) idx + 1);
+    ++cur_depth;
+    max_depth = std::max(max_depth, cur_depth);
+}
+
+void program_t::append(const program_t& src, const instruction_t& instr) {
+    if(instr.op == opcode_t::dup)
+        dup();
+    else if(instr.op == opcode_t::store_tmp)
+        store_temp(instr.arg);
+    else if(instr.op == opcode_t::load_tmp)
+        load_temp(instr.arg);
+    else if(instr.op == opcode_t::load_var)
+        load_var(instr.arg);
+    else if(instr.op == opcode_t::push_const)
+        push_constant(src.get_constants()[instr.arg]);
+    else if(has_immediate(instr.op))
+        apply_imm(
+            instr.op, src.get_constants()[instr.arg],
+            opcode_num_operands(instr.op), opcode_name(instr.op));
+    else
+        apply(instr.op, opcode_num_operands(instr.op), opcode_name(instr.op));
+}
+
+void program_t::check() const {
+    if(!is_valid)
+        throw std::domain_error(err_msg);
+
+    if(cur_depth != 1)
+        throw std::logic_error("postfix_expr_t::evaluate(): could not evaluate expression");
+}
+
+void program_t::invalidate(const std::string& msg) {
+    is_valid = false;
+    err_msg = msg;
+}
+
+
+const char *opcode_name(opcode_t op) {
+    // indexed by opcode_t
+    static const char *names[] = {
+        "nop", "push_const",
+        "add", "sub", "neg", "mul", "div", "pow", "sqrt", "fma", "rsub", "rdiv", "rpow",
+        "dup", "store_tmp", "load_tmp", "load_var",
+        "add_imm", "sub_imm", "mul_imm", "div_imm", "pow_imm",
+        "mul_imm_add", "mul_imm_sub",
+        "halt"
+    };
+    static_assert(
+        sizeof(names) / sizeof(names[0]) == (int) opcode_t::halt + 1,
+        "opcode_name: every opcode must have name"
+    );
+
+    return names[(int) op];
+}
+
+
+int opcode_num_operands(opcode_t op) {
+    switch(op) {
+    case opcode_t::fma:
+        return 3;
+    case opcode_t::add:
+    case opcode_t::sub:
+    case opcode_t::mul:
+    case opcode_t::div:
+    case opcode_t::pow:
+    case opcode_t::rsub:
+    case opcode_t::rdiv:
+    case opcode_t::rpow:
+    case opcode_t::mul_imm_add:
+    case opcode_t::mul_imm_sub:
+        return 2;
+    case opcode_t::neg:
+    case opcode_t::sqrt:
+    case opcode_t::dup:
+    case opcode_t::store_tmp:
+    case opcode_t::add_imm:
+    case opcode_t::sub_imm:
+    case opcode_t::mul_imm:
+    case opcode_t::div_imm:
+    case opcode_t::pow_imm:
+        return 1;
+    case opcode_t::nop:
+    case opcode_t::push_const:
+    case opcode_t::load_tmp:
+    case opcode_t::load_var:
+    case opcode_t::halt:
+        return 0;
+    }
+
+    return 0;
+}
+
+
+/* Interpreter */
+
+// Executes code from [ip] up to [end] or halt, whichever comes first;
+// [ip] is left past halt. Returns value, left on stack
+static inline double execute(
+    const instruction_t *&ip,
+    const instruction_t *end,
+    const double *consts,
+    double *stack,
+    double *temps,
+    const double *vars
+) {
+    // sp points past the top value
+    double *sp = stack;
+
+    for(; ip != end; ++ip) {
+        switch(ip->op) {
+        case opcode_t::push_const:
+            *sp++ = consts[ip->arg];
+            break;
+        case opcode_t::add:
+            sp[-2] = sp[-2] + sp[-1];
+            --sp;
+            break;
+        case opcode_t::sub:
+            sp[-2] = sp[-2] - sp[-1];
+            --sp;
+            break;
+        case opcode_t::neg:
+            sp[-1] = -sp[-1];
+            break;
+        case opcode_t::mul:
+            sp[-2] = sp[-2] * sp[-1];
+            --sp;
+            break;
+        case opcode_t::div:
+            sp[-2] = sp[-2] / sp[-1];
+            --sp;
+            break;
+        case opcode_t::pow:
+            sp[-2] = std::pow(sp[-2], sp[-1]);
+            --sp;
+            break;
+        case opcode_t::sqrt:
+            sp[-1] = pow_half(sp[-1]);
+            break;
+        case opcode_t::fma:
+            sp[-3] = std::fma(sp[-3], sp[-2], sp[-1]);
+            sp -= 2;
+            break;
+        case opcode_t::rsub:
+            sp[-2] = sp[-1] - sp[-2];
+            --sp;
+            break;
+        case opcode_t::rdiv:
+            sp[-2] = sp[-1] / sp[-2];
+            --sp;
+            break;
+        case opcode_t::rpow:
+            sp[-2] = std::pow(sp[-1], sp[-2]);
+            --sp;
+            break;
+        case opcode_t::dup:
+            sp[0] = sp[-1];
+            ++sp;
+            break;
+        case opcode_t::store_tmp:
+            temps[ip->arg] = sp[-1];
+            break;
+        case opcode_t::load_tmp:
+            *sp++ = temps[ip->arg];
+            break;
+        case opcode_t::load_var:
+            *sp++ = vars[ip->arg];
+            break;
+        case opcode_t::add_imm:
+            sp[-1] = sp[-1] + consts[ip->arg];
+            break;
+        case opcode_t::sub_imm:
+            sp[-1] = sp[-1] - consts[ip->arg];
+            break;
+        case opcode_t::mul_imm:
+            sp[-1] = sp[-1] * consts[ip->arg];
+            break;
+        case opcode_t::div_imm:
+            sp[-1] = sp[-1] / consts[ip->arg];
+            break;
+        case opcode_t::pow_imm:
+            sp[-1] = std::pow(sp[-1], consts[ip->arg]);
+            break;
+        case opcode_t::mul_imm_add:
+            sp[-2] = sp[-2] + sp[-1] * consts[ip->arg];
+            --sp;
+            break;
+        case opcode_t::mul_imm_sub:
+            sp[-2] = sp[-2] - sp[-1] * consts[ip->arg];
+            --sp;
+            break;
+        case opcode_t::nop:
+            break;
+        case opcode_t::halt:
+            ++ip;
+            goto done;
+        }
+    }
+
+done:
+    assert(sp == stack + 1);
+    return stack[0];
+}
+
+double interpret(const program_t& prog, double *scratch) {
+    const instruction_t *ip = prog.get_code().begin();
+
+    return execute(
+        ip, prog.get_code().end(),
+        prog.get_constants().begin(),
+        scratch,
+        scratch + prog.get_max_depth(),
+        scratch + prog.get_variables_offset()
+    );
+}
+
+
+/* program_set_t */
+
+int program_set_t::add(const program_t& prog) {
+    prog.check();
+
+    entry_t entry = { (int) code.size(), (int) constants.size() };
+    entries.push_back(entry);
+
+    // constants of program follow those of previous ones, references to them are rebased
+    const util::vector<instruction_t>& prog_code = prog.get_code();
+    for(int i = 0; i < prog_code.size(); ++i) {
+        instruction_t instr = prog_code[i];
+        if(has_immediate(instr.op))
+            instr.arg += entry.constants_offset;
+        code.push_back(instr);
+    }
+
+    instruction_t halt = { opcode_t::halt, 0 };
+    code.push_back(halt);
+
+    const util::vector<double>& prog_constants = prog.get_constants();
+    for(int i = 0; i < prog_constants.size(); ++i)
+        constants.push_back(prog_constants[i]);
+
+    max_depth = std::max(max_depth, prog.get_max_depth());
+    num_temps = std::max(num_temps, prog.get_num_temps());
+    num_vars = std::max(num_vars, prog.get_num_variables());
+
+    if(scratch.size() < get_scratch_size())
+        scratch = util::vector<double>(get_scratch_size());
+
+    return entries.size() - 1;
+}
+
+double program_set_t::evaluate(int idx, const double *values) {
+    assert(idx >= 0 && idx < size());
+    prepare(values);
+
+    const instruction_t *ip = code.begin() + entries[idx].code_offset;
+    return execute(ip, code.end(), constants.begin(), scratch.begin(), temps(), vars());
+}
+
+void program_set_t::evaluate_all(double *results, const double *values) {
+    prepare(values);
+
+    // Programs follow each other, every one ending with halt:
+    // single pass over code evaluates them all
+    const instruction_t *ip = code.begin(), *end = code.end();
+    double *stack = scratch.begin(), *tmp = temps();
+    const double *consts = constants.begin(), *var = vars();
+
+    for(int i = 0; i < entries.size(); ++i)
+        results[i] = execute(ip, end, consts, stack, tmp, var);
+}
+
+void program_set_t::prepare(const double *values) {
+    if(num_vars == 0)
+        return;
+    if(values == NULL)
+        throw std::logic_error("program_set_t: programs have variables, their values are required");
+
+    std::copy(values, values + num_vars, vars());
+}
+
+
+/* threaded_program_t */
+
+threaded_program_t::threaded_program_t(const program_t& prog):
+    max_depth(prog.get_max_depth())
+{
+    const void * const *handlers = NULL;
+    execute(NULL, NULL, NULL, &handlers);
+
+    const util::vector<instruction_t>& src = prog.get_code();
+    for(int i = 0; i < src.size(); ++i) {
+        cell_t cell;
+        cell.op = src[i].op;
+        cell.handler = handlers ? handlers[(int) cell.op] : NULL;
+        cell.arg = src[i].arg;
+        cell.imm = 0;
+        if(has_immediate(cell.op))
+            cell.imm = prog.get_constants()[src[i].arg];
+
+        // variables follow temporaries
+        if(cell.op == opcode_t::load_var)
+            cell.arg += prog.get_num_temps();
+
+        code.push_back(cell);
+    }
+
+    cell_t halt = { handlers ? handlers[(int) opcode_t::halt] : NULL, opcode_t::halt, 0, 0 };
+    code.push_back(halt);
+}
+
+double threaded_program_t::run(double *scratch) const {
+    assert(!empty());
+    return execute(code.begin(), scratch, scratch + max_depth, NULL);
+}
+
+#if POSTFIX_HAS_COMPUTED_GOTO
+
+double threaded_program_t::execute(
+    const cell_t *ip,
+    double *stack,
+    double *temps,
+    const void * const **handlers_out
+) {
+    // indexed by opcode_t
+    static const void * const handlers[] = {
+        &&do_nop,
+        &&do_push_const,
+        &&do_add,
+        &&do_sub,
+        &&do_neg,
+        &&do_mul,
+        &&do_div,
+        &&do_pow,
+        &&do_sqrt,
+        &&do_fma,
+        &&do_rsub,
+        &&do_rdiv,
+        &&do_rpow,
+        &&do_dup,
+        &&do_store_tmp,
+        &&do_load_tmp,
+        &&do_load_var,
+        &&do_add_imm,
+        &&do_sub_imm,
+        &&do_mul_imm,
+        &&do_div_imm,
+        &&do_pow_imm,
+        &&do_mul_imm_add,
+        &&do_mul_imm_sub,
+        &&do_halt
+    };
+    static_assert(
+        sizeof(handlers) / sizeof(handlers[0]) == (int) opcode_t::halt + 1,
+        "threaded_program_t: every opcode must have handler"
+    );
+
+    if(handlers_out != NULL) {
+        *handlers_out = handlers;
+        return 0;
+    }
+
+    double *sp = stack;
+
+// jump to handler of next instruction
+#define DISPATCH() goto *(++ip)->handler
+
+    goto *ip->handler;
+
+do_nop:
+    DISPATCH();
+do_push_const:
+    *sp++ = ip->imm;
+    DISPATCH();
+do_add:
+    sp[-2] = sp[-2] + sp[-1];
+    --sp;
+    DISPATCH();
+do_sub:
+    sp[-2] = sp[-2] - sp[-1];
+    --sp;
+    DISPATCH();
+do_neg:
+    sp[-1] = -sp[-1];
+    DISPATCH();
+do_mul:
+    sp[-2] = sp[-2] * sp[-1];
+    --sp;
+    DISPATCH();
+do_div:
+    sp[-2] = sp[-2] / sp[-1];
+    --sp;
+    DISPATCH();
+do_pow:
+    sp[-2] = std::pow(sp[-2], sp[-1]);
+    --sp;
+    DISPATCH();
+do_sqrt:
+    sp[-1] = pow_half(sp[-1]);
+    DISPATCH();
+do_fma:
+    sp[-3] = std::fma(sp[-3], sp[-2], sp[-1]);
+    sp -= 2;
+    DISPATCH();
+do_rsub:
+    sp[-2] = sp[-1] - sp[-2];
+    --sp;
+    DISPATCH();
+do_rdiv:
+    sp[-2] = sp[-1] / sp[-2];
+    --sp;
+    DISPATCH();
+do_rpow:
+    sp[-2] = std::pow(sp[-1], sp[-2]);
+    --sp;
+    DISPATCH();
+do_dup:
+    sp[0] = sp[-1];
+    ++sp;
+    DISPATCH();
+do_store_tmp:
+    temps[ip->arg] = sp[-1];
+    DISPATCH();
+do_load_tmp:
+do_load_var:
+    *sp++ = temps[ip->arg];
+    DISPATCH();
+do_add_imm:
+    sp[-1] = sp[-1] + ip->imm;
+    DISPATCH();
+do_sub_imm:
+    sp[-1] = sp[-1] - ip->imm;
+    DISPATCH();
+do_mul_imm:
+    sp[-1] = sp[-1] * ip->imm;
+    DISPATCH();
+do_div_imm:
+    sp[-1] = sp[-1] / ip->imm;
+    DISPATCH();
+do_pow_imm:
+    sp[-1] = std::pow(sp[-1], ip->imm);
+    DISPATCH();
+do_mul_imm_add:
+    sp[-2] = sp[-2] + sp[-1] * ip->imm;
+    --sp;
+    DISPATCH();
+do_mul_imm_sub:
+    sp[-2] = sp[-2] - sp[-1] * ip->imm;
+    --sp;
+    DISPATCH();
+do_halt:
+#undef DISPATCH
+
+    assert(sp == stack + 1);
+    return stack[0];
+}
+
+#else
+
+// Portable fallback: switch over the same cells
+double threaded_program_t::execute(
+    const cell_t *ip,
+    double *stack,
+    double *temps,
+    const void * const **handlers_out
+) {
+    if(handlers_out != NULL) {
+        *handlers_out = NULL;
+        return 0;
+    }
+
+    double *sp = stack;
+    for(;; ++ip) {
+        switch(ip->op) {
+        case opcode_t::push_const:
+            *sp++ = ip->imm;
+            break;
+        case opcode_t::add:
+            sp[-2] = sp[-2] + sp[-1];
+            --sp;
+            break;
+        case opcode_t::sub:
+            sp[-2] = sp[-2] - sp[-1];
+            --sp;
+            break;
+        case opcode_t::neg:
+            sp[-1] = -sp[-1];
+            break;
+        case opcode_t::mul:
+            sp[-2] = sp[-2] * sp[-1];
+            --sp;
+            break;
+        case opcode_t::div:
+            sp[-2] = sp[-2] / sp[-1];
+            --sp;
+            break;
+        case opcode_t::pow:
+            sp[-2] = std::pow(sp[-2], sp[-1]);
+            --sp;
+            break;
+        case opcode_t::sqrt:
+            sp[-1] = pow_half(sp[-1]);
+            break;
+        case opcode_t::fma:
+            sp[-3] = std::fma(sp[-3], sp[-2], sp[-1]);
+            sp -= 2;
+            break;
+        case opcode_t::rsub:
+            sp[-2] = sp[-1] - sp[-2];
+            --sp;
+            break;
+        case opcode_t::rdiv:
+            sp[-2] = sp[-1] / sp[-2];
+            --sp;
+            break;
+        case opcode_t::rpow:
+            sp[-2] = std::pow(sp[-1], sp[-2]);
+            --sp;
+            break;
+        case opcode_t::dup:
+            sp[0] = sp[-1];
+            ++sp;
+            break;
+        case opcode_t::store_tmp:
+            temps[ip->arg] = sp[-1];
+            break;
+        case opcode_t::load_tmp:
+        case opcode_t::load_var:
+            *sp++ = temps[ip->arg];
+            break;
+        case opcode_t::add_imm:
+            sp[-1] = sp[-1] + ip->imm;
+            break;
+        case opcode_t::sub_imm:
+            sp[-1] = sp[-1] - ip->imm;
+            break;
+        case opcode_t::mul_imm:
+            sp[-1] = sp[-1] * ip->imm;
+            break;
+        case opcode_t::div_imm:
+            sp[-1] = sp[-1] / ip->imm;
+            break;
+        case opcode_t::pow_imm:
+            sp[-1] = std::pow(sp[-1], ip->imm);
+            break;
+        case opcode_t::mul_imm_add:
+            sp[-2] = sp[-2] + sp[-1] * ip->imm;
+            --sp;
+            break;
+        case opcode_t::mul_imm_sub:
+            sp[-2] = sp[-2] - sp[-1] * ip->imm;
+            --sp;
+            break;
+        case opcode_t::nop:
+            break;
+        case opcode_t::halt:
+            assert(sp == stack + 1);
+            return stack[0];
+        }
+    }
+}
+
+#endif
+
+} // namespace postfix::bytecode
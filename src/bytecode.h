@@ -0,0 +1,285 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+/**
+ * Flat bytecode representation of postfix expression
+ *      Opcodes
+ *      Program (code + constant pool)
+ *      Interpreter
+ *      Packed set of programs
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "util/vector.h"
+
+namespace postfix::bytecode {
+
+// Operations of stack machine
+// Binary operators pop 2 values and push 1, unary pop 1 and push 1
+enum class opcode_t : std::uint8_t {
+    nop,            /*emitted nowhere, used by identity operators (e.g. unary plus)*/
+    push_const,     /*push constants[arg]*/
+    add,
+    sub,
+    neg,
+    mul,
+    div,
+    pow,
+    sqrt,           /*pow(x, 0.5), see pow_half*/
+    fma,            /*x * y + z, rounded once*/
+    rsub,           /*y - x, where y is on top (operands evaluated in reverse order)*/
+    rdiv,           /*y / x, where y is on top*/
+    rpow,           /*pow(y, x), where y is on top*/
+    dup,            /*push copy of top value*/
+    store_tmp,      /*copy top value into temporaries[arg], value stays on stack*/
+    load_tmp,       /*push temporaries[arg]*/
+    load_var,       /*push variables[arg]*/
+    /*superinstructions, arg is index of immediate in constant pool*/
+    add_imm,        /*x + imm*/
+    sub_imm,        /*x - imm*/
+    mul_imm,        /*x * imm*/
+    div_imm,        /*x / imm*/
+    pow_imm,        /*pow(x, imm)*/
+    mul_imm_add,    /*x + y * imm*/
+    mul_imm_sub,    /*x - y * imm*/
+    halt            /*terminates threaded code, never emitted into program*/
+};
+
+// name of opcode, e.g. for profiling reports
+const char *opcode_name(opcode_t op);
+
+// number of values, which opcode takes from stack
+int opcode_num_operands(opcode_t op);
+
+// true, if arg of opcode is index of immediate in constant pool
+inline bool has_immediate(opcode_t op) {
+    return op == opcode_t::push_const || (op >= opcode_t::add_imm && op < opcode_t::halt);
+}
+
+// pow(x, 0.5), computed by square root
+// Matches pow also where sqrt differs: pow(-0, 0.5) = +0, pow(-inf, 0.5) = +inf
+inline double pow_half(double x) {
+    return x == -HUGE_VAL ? HUGE_VAL : std::sqrt(x) + 0.0;
+}
+
+struct instruction_t {
+    opcode_t op;
+    std::uint32_t arg; /*meaning depends on op, e.g. index into constant pool*/
+};
+
+// Compiled postfix expression
+// Code is validated while it is emitted, so that interpreter does not check operands
+class program_t {
+public:
+    program_t(): cur_depth(0), max_depth(0), max_num_operands(0), num_temps(0), num_vars(0), is_valid(true) {}
+
+    // Append push of constant [val]
+    void push_constant(double val);
+
+    // Append operator [op], which consumes [num_operands] values
+    // [name] is used only for error reporting
+    void apply(opcode_t op, int num_operands, const std::string& name);
+
+    // Append operator [op] with immediate operand [imm]
+    // [num_operands] are taken from stack, immediate is not counted
+    void apply_imm(opcode_t op, double imm, int num_operands, const std::string& name);
+
+    // Append duplication of top value
+    void dup();
+
+    // Append copy of top value into temporary [idx]
+    void store_temp(std::uint32_t idx);
+
+    // Append push of temporary [idx], which must be stored before
+    void load_temp(std::uint32_t idx);
+
+    // Append push of variable [idx]
+    void load_var(std::uint32_t idx);
+
+    // Append [instr] of program [src] without changes; its immediate is taken from [src]'s constants
+    void append(const program_t& src, const instruction_t& instr);
+
+    // Throws, if program can not be evaluated
+    void check() const;
+
+    // true, if program can be evaluated
+    bool valid() const {
+        return is_valid && cur_depth == 1;
+    }
+
+    const util::vector<instruction_t>& get_code() const {
+        return code;
+    }
+
+    const util::vector<double>& get_constants() const {
+        return constants;
+    }
+
+    // max number of values residing on stack during evaluation
+    int get_max_depth() const {
+        return max_depth;
+    }
+
+    // max number of operands, consumed by single operator
+    int get_max_num_operands() const {
+        return max_num_operands;
+    }
+
+    // number of temporaries, used by store_tmp/load_tmp
+    int get_num_temps() const {
+        return num_temps;
+    }
+
+    // number of variables, used by load_var
+    int get_num_variables() const {
+        return num_vars;
+    }
+
+    // position of first variable in scratch
+    int get_variables_offset() const {
+        return max_depth + num_temps;
+    }
+
+    // Values needed by interpreters: stack, followed by temporaries and variables
+    // Variables are set by caller before evaluation
+    int get_scratch_size() const {
+        return max_depth + num_temps + num_vars;
+    }
+
+private:
+    util::vector<instruction_t> code;
+    util::vector<double> constants;
+
+    int cur_depth;
+    int max_depth;
+    int max_num_operands;
+    int num_temps;
+    int num_vars;
+
+    bool is_valid;
+    std::string err_msg;
+
+    void invalidate(const std::string& msg);
+};
+
+// Switch-based interpreter
+// [scratch] must hold at least prog.get_scratch_size() values
+double interpret(const program_t& prog, double *scratch);
+
+// Many programs, packed into contiguous buffers of code and constants,
+// so that evaluation of all of them walks memory sequentially instead of
+// visiting separately allocated program of every expression.
+// Every program ends with halt; table of offsets locates single program
+class program_set_t {
+public:
+    program_set_t(): max_depth(0), num_temps(0), num_vars(0) {}
+
+    // Appends [prog], returns its index
+    // Throws, if program is invalid
+    int add(const program_t& prog);
+
+    int size() const {
+        return entries.size();
+    }
+
+    // stack, temporaries and variables, shared by all programs
+    int get_scratch_size() const {
+        return max_depth + num_temps + num_vars;
+    }
+
+    const util::vector<instruction_t>& get_code() const {
+        return code;
+    }
+
+    const util::vector<double>& get_constants() const {
+        return constants;
+    }
+
+    // evaluates program [idx], where variable of slot v is values[v]
+    // [values] may be NULL, if programs have no variables, otherwise throws
+    double evaluate(int idx, const double *values = NULL);
+
+    // results[i] = value of program i, for every program
+    void evaluate_all(double *results, const double *values = NULL);
+
+private:
+    struct entry_t {
+        int code_offset;
+        int constants_offset;
+    };
+
+    util::vector<instruction_t> code; /*programs one after another*/
+    util::vector<double> constants;
+    util::vector<entry_t> entries;
+
+    int max_depth;
+    int num_temps;
+    int num_vars;
+
+    util::vector<double> scratch;
+
+    double *temps() {
+        return scratch.begin() + max_depth;
+    }
+
+    double *vars() {
+        return scratch.begin() + max_depth + num_temps;
+    }
+
+    // copies values of variables into scratch
+    void prepare(const double *values);
+};
+
+// GCC and Clang support labels as values, used for threaded dispatch
+#ifndef POSTFIX_HAS_COMPUTED_GOTO
+#if defined(__GNUC__)
+#define POSTFIX_HAS_COMPUTED_GOTO 1
+#else
+#define POSTFIX_HAS_COMPUTED_GOTO 0
+#endif
+#endif
+
+// Direct-threaded form of program
+// Each instruction holds address of its handler and its immediate value,
+// so that every handler jumps straight to the next one.
+// Falls back to switch-based interpreter, if computed goto is unavailable
+class threaded_program_t {
+public:
+    threaded_program_t(): max_depth(0) {}
+
+    explicit threaded_program_t(const program_t& prog);
+
+    bool empty() const {
+        return code.empty();
+    }
+
+    // [scratch] must hold at least scratch_size values of source program
+    double run(double *scratch) const;
+
+private:
+    struct cell_t {
+        const void *handler;
+        opcode_t op;
+        std::uint32_t arg;  /*index of temporary*/
+        double imm;         /*inlined constant*/
+    };
+
+    util::vector<cell_t> code; /*terminated by halt cell*/
+    int max_depth; /*temporaries follow stack in scratch*/
+
+    // Executes code starting at [ip]
+    // If [handlers_out] is not NULL, only returns handlers table, indexed by opcode
+    static double execute(
+        const cell_t *ip,
+        double *stack,
+        double *temps,
+        const void * const **handlers_out
+    );
+};
+
+} // namespace postfix::bytecode
+
+#endif
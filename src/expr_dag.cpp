@@ -0,0 +1,334 @@
+#include "expr_dag.h"
+#include "scheduling.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+std::uint64_t bits_of(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Operator, which is applied to immediate by superinstruction or to reversed operands
+op_t basic_op_of(op_t op) {
+    switch(op) {
+    case op_t::add_imm: return op_t::add;
+    case op_t::sub_imm: return op_t::sub;
+    case op_t::mul_imm: return op_t::mul;
+    case op_t::div_imm: return op_t::div;
+    case op_t::pow_imm: return op_t::pow;
+    case op_t::rsub: return op_t::sub;
+    case op_t::rdiv: return op_t::div;
+    case op_t::rpow: return op_t::pow;
+    default: return op;
+    }
+}
+
+} // namespace
+
+
+/* expr_dag_t */
+
+bool expr_dag_t::node_key_t::operator==(const node_key_t& other) const {
+    if(op != other.op || value_bits != other.value_bits)
+        return false;
+
+    for(int i = 0; i < max_node_children; ++i)
+        if(children[i] != other.children[i])
+            return false;
+
+    return true;
+}
+
+std::size_t expr_dag_t::node_key_hash_t::operator()(const node_key_t& key) const {
+    std::uint64_t h = (std::uint64_t) key.op;
+    h = h * 0x9E3779B97F4A7C15ull ^ key.value_bits;
+    for(int i = 0; i < max_node_children; ++i)
+        h = h * 0x9E3779B97F4A7C15ull ^ (std::uint32_t) key.children[i];
+
+    return (std::size_t) (h ^ (h >> 29));
+}
+
+int expr_dag_t::add_node(const dag_node_t& node) {
+    if(!is_hash_consing) {
+        nodes.push_back(node);
+        return nodes.size() - 1;
+    }
+
+    node_key_t key;
+    key.op = node.op;
+    key.value_bits = node.num_children == 0 ? bits_of(node.value) : 0;
+    for(int i = 0; i < max_node_children; ++i)
+        key.children[i] = i < node.num_children ? node.children[i] : -1;
+
+    std::unordered_map<node_key_t, int, node_key_hash_t>::iterator it = node_index.find(key);
+    if(it != node_index.end())
+        return it->second;
+
+    nodes.push_back(node);
+    node_index[key] = nodes.size() - 1;
+    return nodes.size() - 1;
+}
+
+int expr_dag_t::make_const(double value) {
+    dag_node_t node;
+    node.op = op_t::push_const;
+    node.value = value;
+    node.num_children = 0;
+
+    return add_node(node);
+}
+
+int expr_dag_t::make_var(std::uint32_t idx) {
+    dag_node_t node;
+    node.op = op_t::load_var;
+    node.value = idx;
+    node.num_children = 0;
+
+    return add_node(node);
+}
+
+int expr_dag_t::make_node(op_t op, int num_children, const int *children) {
+    assert(0 <= num_children && num_children <= max_node_children);
+
+    dag_node_t node;
+    node.op = op;
+    node.value = 0;
+    node.num_children = num_children;
+    for(int i = 0; i < num_children; ++i) {
+        assert(0 <= children[i] && children[i] < nodes.size());
+        node.children[i] = children[i];
+    }
+
+    return add_node(node);
+}
+
+bool expr_dag_t::from_program(
+    const bytecode::program_t& prog,
+    bool hash_consing,
+    expr_dag_t& dag
+) {
+    dag = expr_dag_t(hash_consing);
+
+    if(!prog.valid())
+        return false;
+
+    const util::vector<bytecode::instruction_t>& code = prog.get_code();
+    const util::vector<double>& constants = prog.get_constants();
+
+    // nodes of values on stack
+    util::vector<int> stack;
+    util::vector<int> temps(prog.get_num_temps(), -1);
+
+    for(int i = 0; i < code.size(); ++i) {
+        const bytecode::instruction_t& instr = code[i];
+
+        switch(instr.op) {
+        case op_t::push_const:
+            stack.push_back(dag.make_const(constants[instr.arg]));
+            break;
+
+        case op_t::add:
+        case op_t::sub:
+        case op_t::mul:
+        case op_t::div:
+        case op_t::pow: {
+            int rhs = stack[stack.size() - 1];
+            stack.pop_back();
+            int lhs = stack[stack.size() - 1];
+            stack.pop_back();
+            stack.push_back(dag.make_binary(instr.op, lhs, rhs));
+            break;
+        }
+
+        /*operands are in reverse order: lhs is on top*/
+        case op_t::rsub:
+        case op_t::rdiv:
+        case op_t::rpow: {
+            int lhs = stack[stack.size() - 1];
+            stack.pop_back();
+            int rhs = stack[stack.size() - 1];
+            stack.pop_back();
+            stack.push_back(dag.make_binary(basic_op_of(instr.op), lhs, rhs));
+            break;
+        }
+
+        case op_t::fma: {
+            int children[3];
+            for(int j = 2; j >= 0; --j) {
+                children[j] = stack[stack.size() - 1];
+                stack.pop_back();
+            }
+            stack.push_back(dag.make_node(instr.op, 3, children));
+            break;
+        }
+
+        case op_t::neg:
+        case op_t::sqrt: {
+            int operand = stack[stack.size() - 1];
+            stack.pop_back();
+            stack.push_back(dag.make_unary(instr.op, operand));
+            break;
+        }
+
+        /*immediate becomes constant operand*/
+        case op_t::add_imm:
+        case op_t::sub_imm:
+        case op_t::mul_imm:
+        case op_t::div_imm:
+        case op_t::pow_imm: {
+            int lhs = stack[stack.size() - 1];
+            stack.pop_back();
+            int imm = dag.make_const(constants[instr.arg]);
+            stack.push_back(dag.make_binary(basic_op_of(instr.op), lhs, imm));
+            break;
+        }
+
+        /*x +- y * imm*/
+        case op_t::mul_imm_add:
+        case op_t::mul_imm_sub: {
+            int y = stack[stack.size() - 1];
+            stack.pop_back();
+            int x = stack[stack.size() - 1];
+            stack.pop_back();
+            int prod = dag.make_binary(op_t::mul, y, dag.make_const(constants[instr.arg]));
+            op_t op = instr.op == op_t::mul_imm_add ? op_t::add : op_t::sub;
+            stack.push_back(dag.make_binary(op, x, prod));
+            break;
+        }
+
+        case op_t::dup: {
+            int top = stack[stack.size() - 1]; /*push_back may reallocate stack*/
+            stack.push_back(top);
+            break;
+        }
+        case op_t::store_tmp:
+            temps[instr.arg] = stack[stack.size() - 1];
+            break;
+        case op_t::load_tmp:
+            stack.push_back(temps[instr.arg]);
+            break;
+        case op_t::load_var:
+            stack.push_back(dag.make_var(instr.arg));
+            break;
+
+        case op_t::nop:
+            break;
+
+        default: /*opcode is not represented by DAG*/
+            return false;
+        }
+    }
+
+    assert(stack.size() == 1);
+    dag.set_root(stack[0]);
+
+    return true;
+}
+
+util::vector<int> expr_dag_t::count_uses() const {
+    util::vector<int> uses(nodes.size(), 0);
+    if(root < 0)
+        return uses;
+
+    uses[root] = 1;
+    // parents follow children, so every parent is visited before its children
+    for(int i = nodes.size() - 1; i >= 0; --i) {
+        if(uses[i] == 0) /*unreachable*/
+            continue;
+
+        const dag_node_t& node = nodes[i];
+        for(int j = 0; j < node.num_children; ++j) {
+            bool repeated = false;
+            for(int k = 0; k < j; ++k)
+                repeated = repeated || node.children[k] == node.children[j];
+
+            if(!repeated)
+                ++uses[node.children[j]];
+        }
+    }
+
+    return uses;
+}
+
+bytecode::program_t expr_dag_t::to_program(const util::vector<bool> *reversed) const {
+    bytecode::program_t prog;
+    if(root < 0)
+        return prog;
+
+    util::vector<int> uses = count_uses();
+    // temporary of shared node, -1 until node is emitted
+    util::vector<int> temp_of(nodes.size(), -1);
+    std::uint32_t num_temps = 0;
+
+    // Post-order traversal with explicit stack, expressions may be very deep
+    struct frame_t {
+        int node;
+        int next_child;
+    };
+
+    util::vector<frame_t> frames;
+    frame_t root_frame = { root, 0 };
+    frames.push_back(root_frame);
+
+    while(!frames.empty()) {
+        frame_t& frame = frames[frames.size() - 1];
+        const int idx = frame.node;
+        const dag_node_t& node = nodes[idx];
+
+        if(node.op == op_t::push_const) { /*constants are cheaper to push than to load*/
+            prog.push_constant(node.value);
+            frames.pop_back();
+            continue;
+        }
+
+        if(node.op == op_t::load_var) { /*as are variables*/
+            prog.load_var((std::uint32_t) node.value);
+            frames.pop_back();
+            continue;
+        }
+
+        if(frame.next_child == 0 && temp_of[idx] >= 0) { /*already evaluated*/
+            prog.load_temp(temp_of[idx]);
+            frames.pop_back();
+            continue;
+        }
+
+        const bool is_reversed = reversed != NULL && (*reversed)[idx];
+
+        if(frame.next_child < node.num_children) {
+            int pos = frame.next_child;
+            int child = node.children[is_reversed ? 1 - pos : pos];
+            ++frame.next_child;
+
+            // the same operand twice, e.g. x * x
+            if(pos > 0 && node.children[pos - 1] == child && !is_reversed) {
+                prog.dup();
+                continue;
+            }
+
+            frame_t child_frame = { child, 0 };
+            frames.push_back(child_frame); /*invalidates frame*/
+            continue;
+        }
+
+        op_t op = is_reversed ? reversed_operator(node.op) : node.op;
+        prog.apply(op, node.num_children, bytecode::opcode_name(op));
+        if(uses[idx] > 1) {
+            temp_of[idx] = num_temps++;
+            prog.store_temp(temp_of[idx]);
+        }
+        frames.pop_back();
+    }
+
+    return prog;
+}
+
+} // namespace postfix::optimizer
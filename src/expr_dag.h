@@ -0,0 +1,125 @@
+#ifndef EXPR_DAG_H
+#define EXPR_DAG_H
+
+/**
+ * Expression DAG
+ *      Built from bytecode program, structurally identical subtrees are shared
+ *      Emitted back into program, shared subtrees are evaluated once
+*/
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "bytecode.h"
+
+#include "util/vector.h"
+
+namespace postfix::optimizer {
+
+const int max_node_children = 3;
+
+// Node of expression DAG
+// Children always precede their parents in node list
+struct dag_node_t {
+    bytecode::opcode_t op;      /*push_const for constants, load_var for variables, basic operator otherwise*/
+    double value;               /*value of constant or index of variable*/
+    int num_children;
+    int children[max_node_children];
+};
+
+// Rewrite, performed by optimization pass, e.g. for auditing
+struct rewrite_t {
+    const char *rule;           /*e.g. "pow_to_sqrt"*/
+    std::string description;    /*e.g. "exp(x, 0.5) -> sqrt(x)"*/
+};
+
+class expr_dag_t {
+public:
+    expr_dag_t(): root(-1), is_hash_consing(true) {}
+
+    // [hash_consing] - share structurally identical nodes
+    explicit expr_dag_t(bool hash_consing): root(-1), is_hash_consing(hash_consing) {}
+
+    // Builds DAG of [prog]
+    // Returns false, if program is invalid or has opcodes, which DAG does not represent
+    static bool from_program(
+        const bytecode::program_t& prog,
+        bool hash_consing,
+        expr_dag_t& dag /*out*/
+    );
+
+    // Emits program, which evaluates every shared node once:
+    // first use stores it into temporary, other uses load it.
+    // Node, used twice by the same parent (e.g. x * x), is duplicated instead.
+    // Binary nodes, marked in [reversed] (e.g. by schedule_operands), evaluate
+    // second operand first and are emitted as reversed operators
+    bytecode::program_t to_program(const util::vector<bool> *reversed = NULL) const;
+
+    // Add (or find identical) constant node
+    int make_const(double value);
+
+    // Add (or find identical) node of variable [idx]
+    int make_var(std::uint32_t idx);
+
+    // Add (or find identical) operator node
+    int make_node(bytecode::opcode_t op, int num_children, const int *children);
+
+    int make_unary(bytecode::opcode_t op, int child) {
+        return make_node(op, 1, &child);
+    }
+
+    int make_binary(bytecode::opcode_t op, int lhs, int rhs) {
+        int children[2] = { lhs, rhs };
+        return make_node(op, 2, children);
+    }
+
+    const dag_node_t& get_node(int idx) const {
+        return nodes[idx];
+    }
+
+    int size() const {
+        return nodes.size();
+    }
+
+    bool hash_consing() const {
+        return is_hash_consing;
+    }
+
+    int get_root() const {
+        return root;
+    }
+
+    void set_root(int new_root) {
+        root = new_root;
+    }
+
+    // Number of parents' references to every node (root is referenced once)
+    util::vector<int> count_uses() const;
+
+private:
+    // Structural key of node: opcode, children and bits of value of leaf
+    struct node_key_t {
+        bytecode::opcode_t op;
+        std::uint64_t value_bits;
+        int children[max_node_children];
+
+        bool operator==(const node_key_t& other) const;
+    };
+
+    struct node_key_hash_t {
+        std::size_t operator()(const node_key_t& key) const;
+    };
+
+    util::vector<dag_node_t> nodes;
+    int root;
+
+    bool is_hash_consing;
+    std::unordered_map<node_key_t, int, node_key_hash_t> node_index;
+
+    int add_node(const dag_node_t& node);
+};
+
+} // namespace postfix::optimizer
+
+#endif
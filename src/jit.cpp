@@ -0,0 +1,334 @@
+#include "jit.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if POSTFIX_HAS_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace postfix::jit {
+
+namespace {
+
+// x86-64 machine code emitter
+// Only xmm0 and xmm1 are used as arithmetic registers.
+// rbx holds pointer to value stack, rbp holds pointer to constants
+class x64_emitter_t {
+public:
+    explicit x64_emitter_t(util::vector<std::uint8_t>& out_code): code(out_code) {}
+
+    // SSE2 opcodes (F2 0F xx)
+    enum sse_op_t {
+        movsd_load = 0x10,
+        movsd_store = 0x11,
+        addsd = 0x58,
+        mulsd = 0x59,
+        subsd = 0x5C,
+        divsd = 0x5E
+    };
+
+    enum base_t {
+        stack_base = 3,     /*rbx*/
+        const_base = 5      /*rbp*/
+    };
+
+    void prologue() {
+        bytes({ 0x53 });                    // push rbx
+        bytes({ 0x55 });                    // push rbp
+        bytes({ 0x48, 0x83, 0xEC, 0x08 });  // sub rsp, 8 (align stack for calls)
+        bytes({ 0x48, 0x89, 0xFB });        // mov rbx, rdi
+        bytes({ 0x48, 0x89, 0xF5 });        // mov rbp, rsi
+    }
+
+    void epilogue() {
+        bytes({ 0x48, 0x83, 0xC4, 0x08 });  // add rsp, 8
+        bytes({ 0x5D });                    // pop rbp
+        bytes({ 0x5B });                    // pop rbx
+        bytes({ 0xC3 });                    // ret
+    }
+
+    // op xmm[reg], [base + 8 * idx]
+    void sse_mem(sse_op_t op, int reg, base_t base, std::uint32_t idx) {
+        bytes({ 0xF2, 0x0F, (std::uint8_t) op });
+        // mod = 10 (disp32), reg, rm = base
+        byte(0x80 | (reg << 3) | base);
+        disp32(idx * 8);
+    }
+
+    // op xmm[dst], xmm[src]
+    void sse_reg(sse_op_t op, int dst, int src) {
+        bytes({ 0xF2, 0x0F, (std::uint8_t) op });
+        byte(0xC0 | (dst << 3) | src);
+    }
+
+    // movapd xmm[dst], xmm[src]
+    void movapd(int dst, int src) {
+        bytes({ 0x66, 0x0F, 0x28 });
+        byte(0xC0 | (dst << 3) | src);
+    }
+
+    // xmm0 = -xmm0, by flipping sign bit
+    void negate_xmm0() {
+        bytes({ 0x48, 0xB8 });                      // mov rax, imm64
+        imm64(0x8000000000000000ull);
+        bytes({ 0x66, 0x48, 0x0F, 0x6E, 0xC8 });    // movq xmm1, rax
+        bytes({ 0x66, 0x0F, 0x57, 0xC1 });          // xorpd xmm0, xmm1
+    }
+
+    // call absolute address; arguments in xmm0, xmm1, result in xmm0
+    void call(const void *func) {
+        bytes({ 0x48, 0xB8 });      // mov rax, imm64
+        std::uint64_t addr;
+        std::memcpy(&addr, &func, sizeof(addr));
+        imm64(addr);
+        bytes({ 0xFF, 0xD0 });      // call rax
+    }
+
+private:
+    util::vector<std::uint8_t>& code;
+
+    void byte(int val) {
+        code.push_back((std::uint8_t) val);
+    }
+
+    void bytes(std::initializer_list<std::uint8_t> list) {
+        for(std::uint8_t b : list)
+            code.push_back(b);
+    }
+
+    void disp32(std::uint32_t val) {
+        for(int i = 0; i < 4; ++i)
+            byte((val >> (8 * i)) & 0xFF);
+    }
+
+    void imm64(std::uint64_t val) {
+        for(int i = 0; i < 8; ++i)
+            byte((val >> (8 * i)) & 0xFF);
+    }
+};
+
+// pow, as called by generated code
+double call_pow(double base, double exponent) {
+    return std::pow(base, exponent);
+}
+
+double call_pow_half(double x) {
+    return bytecode::pow_half(x);
+}
+
+double call_fma(double x, double y, double z) {
+    return std::fma(x, y, z);
+}
+
+} // namespace
+
+
+/* jit_program_t */
+
+bool jit_program_t::emit(const bytecode::program_t& prog, util::vector<std::uint8_t>& code) {
+    typedef bytecode::opcode_t op_t;
+    typedef x64_emitter_t emitter;
+
+    if(!prog.valid())
+        return false;
+
+    x64_emitter_t em(code);
+    em.prologue();
+
+    // Number of values on stack; value at depth - 1 is kept in xmm0,
+    // values below it are in stack slots
+    std::uint32_t depth = 0;
+    const std::uint32_t temp_base = prog.get_max_depth();
+
+    const util::vector<bytecode::instruction_t>& src = prog.get_code();
+    for(int i = 0; i < src.size(); ++i) {
+        const bytecode::instruction_t& instr = src[i];
+
+        switch(instr.op) {
+        case op_t::push_const:
+            if(depth > 0) /*spill current top*/
+                em.sse_mem(emitter::movsd_store, 0, emitter::stack_base, depth - 1);
+            em.sse_mem(emitter::movsd_load, 0, emitter::const_base, instr.arg);
+            ++depth;
+            break;
+
+        /*commutative: xmm0 = slot op xmm0*/
+        case op_t::add:
+            em.sse_mem(emitter::addsd, 0, emitter::stack_base, depth - 2);
+            --depth;
+            break;
+        case op_t::mul:
+            em.sse_mem(emitter::mulsd, 0, emitter::stack_base, depth - 2);
+            --depth;
+            break;
+
+        /*non-commutative: xmm1 = slot; xmm1 op= xmm0; xmm0 = xmm1*/
+        case op_t::sub:
+        case op_t::div:
+            em.sse_mem(emitter::movsd_load, 1, emitter::stack_base, depth - 2);
+            em.sse_reg(instr.op == op_t::sub ? emitter::subsd : emitter::divsd, 1, 0);
+            em.movapd(0, 1);
+            --depth;
+            break;
+
+        /*reversed: xmm0 = xmm0 op slot*/
+        case op_t::rsub:
+            em.sse_mem(emitter::subsd, 0, emitter::stack_base, depth - 2);
+            --depth;
+            break;
+        case op_t::rdiv:
+            em.sse_mem(emitter::divsd, 0, emitter::stack_base, depth - 2);
+            --depth;
+            break;
+        case op_t::rpow:
+            em.sse_mem(emitter::movsd_load, 1, emitter::stack_base, depth - 2);
+            em.call((const void *) call_pow);
+            --depth;
+            break;
+
+        case op_t::pow:
+            em.movapd(1, 0);
+            em.sse_mem(emitter::movsd_load, 0, emitter::stack_base, depth - 2);
+            em.call((const void *) call_pow);
+            --depth;
+            break;
+
+        case op_t::neg:
+            em.negate_xmm0();
+            break;
+        case op_t::sqrt:
+            em.call((const void *) call_pow_half);
+            break;
+        case op_t::fma: /*xmm0 = fma(slot, slot, xmm0)*/
+            em.movapd(2, 0);
+            em.sse_mem(emitter::movsd_load, 1, emitter::stack_base, depth - 2);
+            em.sse_mem(emitter::movsd_load, 0, emitter::stack_base, depth - 3);
+            em.call((const void *) call_fma);
+            depth -= 2;
+            break;
+
+        /*immediate operand is read from constants*/
+        case op_t::add_imm:
+            em.sse_mem(emitter::addsd, 0, emitter::const_base, instr.arg);
+            break;
+        case op_t::sub_imm:
+            em.sse_mem(emitter::subsd, 0, emitter::const_base, instr.arg);
+            break;
+        case op_t::mul_imm:
+            em.sse_mem(emitter::mulsd, 0, emitter::const_base, instr.arg);
+            break;
+        case op_t::div_imm:
+            em.sse_mem(emitter::divsd, 0, emitter::const_base, instr.arg);
+            break;
+        case op_t::pow_imm:
+            em.sse_mem(emitter::movsd_load, 1, emitter::const_base, instr.arg);
+            em.call((const void *) call_pow);
+            break;
+
+        /*x +- y * imm, y is on top*/
+        case op_t::mul_imm_add:
+            em.sse_mem(emitter::mulsd, 0, emitter::const_base, instr.arg);
+            em.sse_mem(emitter::addsd, 0, emitter::stack_base, depth - 2);
+            --depth;
+            break;
+        case op_t::mul_imm_sub:
+            em.sse_mem(emitter::mulsd, 0, emitter::const_base, instr.arg);
+            em.sse_mem(emitter::movsd_load, 1, emitter::stack_base, depth - 2);
+            em.sse_reg(emitter::subsd, 1, 0);
+            em.movapd(0, 1);
+            --depth;
+            break;
+
+        /*temporaries follow stack slots*/
+        case op_t::dup:
+            em.sse_mem(emitter::movsd_store, 0, emitter::stack_base, depth - 1);
+            ++depth;
+            break;
+        case op_t::store_tmp:
+            em.sse_mem(emitter::movsd_store, 0, emitter::stack_base, temp_base + instr.arg);
+            break;
+        case op_t::load_tmp:
+            if(depth > 0)
+                em.sse_mem(emitter::movsd_store, 0, emitter::stack_base, depth - 1);
+            em.sse_mem(emitter::movsd_load, 0, emitter::stack_base, temp_base + instr.arg);
+            ++depth;
+            break;
+        case op_t::load_var: /*variables follow temporaries*/
+            if(depth > 0)
+                em.sse_mem(emitter::movsd_store, 0, emitter::stack_base, depth - 1);
+            em.sse_mem(emitter::movsd_load, 0, emitter::stack_base, prog.get_variables_offset() + instr.arg);
+            ++depth;
+            break;
+
+        case op_t::nop:
+            break;
+
+        default: /*opcode is not supported by JIT*/
+            return false;
+        }
+    }
+
+    assert(depth == 1);
+    em.epilogue();
+
+    return true;
+}
+
+#if POSTFIX_HAS_JIT
+
+jit_program_t::jit_program_t(const bytecode::program_t& prog):
+    constants(prog.get_constants()),
+    func(NULL)
+{
+    util::vector<std::uint8_t> code;
+    if(!emit(prog, code))
+        return;
+
+    memory = util::shared_ptr<exec_memory_t>(new exec_memory_t(code));
+    func = (func_t) memory->get();
+}
+
+
+/* exec_memory_t */
+
+exec_memory_t::exec_memory_t(const util::vector<std::uint8_t>& code) {
+    std::size_t page = (std::size_t) sysconf(_SC_PAGESIZE);
+    size = (code.size() + page - 1) / page * page;
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mem == MAP_FAILED)
+        throw std::runtime_error("exec_memory_t: could not map memory");
+
+    std::memcpy(mem, code.begin(), code.size());
+
+    // pages are never writable and executable at once
+    if(mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, size);
+        throw std::runtime_error("exec_memory_t: could not make memory executable");
+    }
+}
+
+exec_memory_t::~exec_memory_t() {
+    munmap(mem, size);
+}
+
+#else
+
+// JIT is unavailable, programs are left to interpreters
+jit_program_t::jit_program_t(const bytecode::program_t& prog):
+    func(NULL)
+{}
+
+exec_memory_t::exec_memory_t(const util::vector<std::uint8_t>& code): mem(NULL), size(0) {
+    throw std::runtime_error("exec_memory_t: executable memory is not supported on this platform");
+}
+
+exec_memory_t::~exec_memory_t() {}
+
+#endif
+
+} // namespace postfix::jit
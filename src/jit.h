@@ -0,0 +1,83 @@
+#ifndef JIT_H
+#define JIT_H
+
+/**
+ * Native code generation for bytecode programs
+ *      x86-64 (System V) code emitter, SSE2 arithmetic
+ *      Executable memory management
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bytecode.h"
+
+#include "util/vector.h"
+#include "util/shared_ptr.h"
+
+// JIT is available on x86-64 with mmap
+#ifndef POSTFIX_HAS_JIT
+#if defined(__x86_64__) && defined(__unix__)
+#define POSTFIX_HAS_JIT 1
+#else
+#define POSTFIX_HAS_JIT 0
+#endif
+#endif
+
+namespace postfix::jit {
+
+// Block of executable memory, released on destruction
+class exec_memory_t {
+public:
+    // Copies [code] into freshly mapped pages, which are made executable (and read-only)
+    exec_memory_t(const util::vector<std::uint8_t>& code);
+    ~exec_memory_t();
+
+    const void *get() const {
+        return mem;
+    }
+
+private:
+    void *mem;
+    std::size_t size;
+
+    // pages are owned exclusively
+    exec_memory_t(const exec_memory_t&);
+    exec_memory_t& operator=(const exec_memory_t&);
+};
+
+// Native form of program
+// Value stack (followed by temporaries) lives in memory, top of stack is cached in xmm0.
+// Stack positions are known at compile time, so every access has fixed displacement
+class jit_program_t {
+public:
+    jit_program_t(): func(NULL) {}
+
+    // Compiles [prog]; leaves jit_program_t empty, if JIT is unavailable
+    // on this platform or program contains unsupported opcode
+    explicit jit_program_t(const bytecode::program_t& prog);
+
+    bool compiled() const {
+        return func != NULL;
+    }
+
+    // [scratch] must hold at least scratch_size values of source program
+    double run(double *scratch) const {
+        return func(scratch, constants.begin());
+    }
+
+    // Emits machine code of [prog] into [code]
+    // Returns false, if program contains opcode not supported by JIT
+    static bool emit(const bytecode::program_t& prog, util::vector<std::uint8_t>& code /*out*/);
+
+private:
+    typedef double (*func_t)(double *stack, const double *constants);
+
+    util::shared_ptr<exec_memory_t> memory; /*shared by copies*/
+    util::vector<double> constants;
+    func_t func;
+};
+
+} // namespace postfix::jit
+
+#endif
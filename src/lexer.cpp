@@ -0,0 +1,158 @@
+#include "lexer.h"
+
+#if POSTFIX_HAS_SIMD
+#include <immintrin.h>
+#endif
+
+namespace postfix::lexer {
+
+namespace {
+
+struct class_table_t {
+    std::uint8_t classes[256];
+};
+
+constexpr bool in_range(int c, char lo, char hi) {
+    return c >= lo && c <= hi;
+}
+
+constexpr unsigned classify(int c) {
+    unsigned res = 0;
+    if(c == ' ' || in_range(c, '\t', '\r'))
+        res |= space;
+    if(in_range(c, '0', '9'))
+        res |= digit | identifier;
+    if(in_range(c, 'a', 'z') || in_range(c, 'A', 'Z') || c == '_')
+        res |= identifier;
+    if(c == '.')
+        res |= dot;
+    if(in_range(c, '(', '/') && c != '.')
+        res |= operator_;
+    return res;
+}
+
+constexpr class_table_t make_table() {
+    class_table_t res = {};
+    for(int c = 0; c < 256; ++c)
+        res.classes[c] = classify(c);
+    return res;
+}
+
+// built at compile time, thus usable by static initializers of other units
+constexpr class_table_t table = make_table();
+
+const char *skip_scalar(const char *beg, const char *end, unsigned classes) {
+    while(beg != end && (classes_of(*beg) & classes))
+        ++beg;
+    return beg;
+}
+
+#if POSTFIX_HAS_SIMD
+
+// Vector classification: byte of result is 0xFF, if character is in one of [classes]
+// Ranges are tested on unsigned bytes by min/max, as SSE2 compares only signed ones
+
+inline __m128i in_range_sse2(__m128i x, char lo, char hi) {
+    __m128i clamped = _mm_min_epu8(_mm_max_epu8(x, _mm_set1_epi8(lo)), _mm_set1_epi8(hi));
+    return _mm_cmpeq_epi8(clamped, x);
+}
+
+inline __m128i classify_sse2(__m128i x, unsigned classes) {
+    __m128i res = _mm_setzero_si128();
+    if(classes & space)
+        res = _mm_or_si128(res, _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), in_range_sse2(x, '\t', '\r')));
+    if(classes & (digit | identifier))
+        res = _mm_or_si128(res, in_range_sse2(x, '0', '9'));
+    if(classes & identifier) {
+        // setting bit 0x20 maps A-Z onto a-z, and no other character into it
+        __m128i folded = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        res = _mm_or_si128(res, _mm_or_si128(in_range_sse2(folded, 'a', 'z'), _mm_cmpeq_epi8(x, _mm_set1_epi8('_'))));
+    }
+    if(classes & dot)
+        res = _mm_or_si128(res, _mm_cmpeq_epi8(x, _mm_set1_epi8('.')));
+    if(classes & operator_)
+        res = _mm_or_si128(res, _mm_andnot_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('.')), in_range_sse2(x, '(', '/')));
+    return res;
+}
+
+const char *skip_sse2(const char *beg, const char *end, unsigned classes) {
+    for(; end - beg >= 16; beg += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *) beg);
+        unsigned outside = ~_mm_movemask_epi8(classify_sse2(x, classes)) & 0xFFFF;
+        if(outside != 0)
+            return beg + __builtin_ctz(outside);
+    }
+    return skip_scalar(beg, end, classes);
+}
+
+__attribute__((target("avx2")))
+inline __m256i in_range_avx2(__m256i x, char lo, char hi) {
+    __m256i clamped = _mm256_min_epu8(_mm256_max_epu8(x, _mm256_set1_epi8(lo)), _mm256_set1_epi8(hi));
+    return _mm256_cmpeq_epi8(clamped, x);
+}
+
+__attribute__((target("avx2")))
+inline __m256i classify_avx2(__m256i x, unsigned classes) {
+    __m256i res = _mm256_setzero_si256();
+    if(classes & space)
+        res = _mm256_or_si256(res, _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), in_range_avx2(x, '\t', '\r')));
+    if(classes & (digit | identifier))
+        res = _mm256_or_si256(res, in_range_avx2(x, '0', '9'));
+    if(classes & identifier) {
+        __m256i folded = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        res = _mm256_or_si256(res, _mm256_or_si256(in_range_avx2(folded, 'a', 'z'), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'))));
+    }
+    if(classes & dot)
+        res = _mm256_or_si256(res, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('.')));
+    if(classes & operator_)
+        res = _mm256_or_si256(res, _mm256_andnot_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('.')), in_range_avx2(x, '(', '/')));
+    return res;
+}
+
+__attribute__((target("avx2")))
+const char *skip_avx2(const char *beg, const char *end, unsigned classes) {
+    for(; end - beg >= 32; beg += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) beg);
+        unsigned outside = ~(unsigned) _mm256_movemask_epi8(classify_avx2(x, classes));
+        if(outside != 0)
+            return beg + __builtin_ctz(outside);
+    }
+    return skip_sse2(beg, end, classes);
+}
+
+#endif
+
+typedef const char *(*skip_func_t)(const char *, const char *, unsigned);
+
+skip_func_t select_skip(simd::isa_t isa) {
+    switch(isa) {
+#if POSTFIX_HAS_SIMD
+    case simd::isa_t::avx512:
+    case simd::isa_t::avx2:
+        return skip_avx2;
+    case simd::isa_t::sse2:
+        return skip_sse2;
+#endif
+    default:
+        return skip_scalar;
+    }
+}
+
+} // namespace
+
+const std::uint8_t *const class_table = table.classes;
+
+const char *skip(const char *beg, const char *end, unsigned classes) {
+    // most runs are short, e.g. single space between tokens: they end at the first character
+    if(beg == end || !(classes_of(*beg) & classes))
+        return beg;
+
+    static const skip_func_t func = select_skip(simd::native_isa());
+    return func(beg, end, classes);
+}
+
+const char *skip(const char *beg, const char *end, unsigned classes, simd::isa_t isa) {
+    return select_skip(isa)(beg, end, classes);
+}
+
+} // namespace postfix::lexer
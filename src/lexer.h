@@ -0,0 +1,57 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+/**
+ * Character classes of lexer
+ *      Locale-independent classification table
+ *      Vectorized scanning of runs of classes (SSE2/AVX2, scalar elsewhere)
+*/
+
+#include <cstdint>
+
+#include "simd.h"
+
+namespace postfix::lexer {
+
+// Classes of characters, combined into masks
+enum char_class_t : unsigned {
+    space       = 1 << 0,   /*' ', \t, \n, \v, \f, \r*/
+    digit       = 1 << 1,   /*0-9*/
+    dot         = 1 << 2,   /*.*/
+    operator_   = 1 << 3,   /*( ) * + , - /*/
+    identifier  = 1 << 4    /*letters, _ and digits (identifier may not start with digit)*/
+};
+
+// classes of every character, as of C locale, indexed by unsigned char
+extern const std::uint8_t *const class_table;
+
+inline unsigned classes_of(char c) {
+    return class_table[(unsigned char) c];
+}
+
+inline bool is_space(char c) {
+    return classes_of(c) & space;
+}
+
+inline bool is_digit(char c) {
+    return classes_of(c) & digit;
+}
+
+// Returns the first character of [beg, end), which is in none of [classes], or [end]
+// Checks 16 (SSE2) or 32 (AVX2) characters per step, using instruction set of running CPU
+const char *skip(const char *beg, const char *end, unsigned classes);
+
+// the same, using [isa] (must be supported by running CPU); avx512 scans as avx2
+const char *skip(const char *beg, const char *end, unsigned classes, simd::isa_t isa);
+
+inline const char *skip_spaces(const char *beg, const char *end) {
+    return skip(beg, end, space);
+}
+
+inline const char *skip_digits(const char *beg, const char *end) {
+    return skip(beg, end, digit);
+}
+
+} // namespace postfix::lexer
+
+#endif
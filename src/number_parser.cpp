@@ -0,0 +1,306 @@
+#include "number_parser.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "lexer.h"
+
+namespace postfix::lexer {
+
+namespace detail {
+
+namespace {
+
+// IEEE 754 binary64
+const int mantissa_explicit_bits = 52;
+const int minimum_exponent = -1023;
+const int infinite_power = 0x7FF;
+
+// range of q, where w * 10^q may be exactly halfway between doubles
+const int min_exponent_round_to_even = -4;
+const int max_exponent_round_to_even = 23;
+
+#ifdef __SIZEOF_INT128__
+
+struct value128_t {
+    std::uint64_t low;
+    std::uint64_t high;
+};
+
+value128_t full_multiplication(std::uint64_t a, std::uint64_t b) {
+    unsigned __int128 product = (unsigned __int128) a * b;
+    value128_t res = { (std::uint64_t) product, (std::uint64_t) (product >> 64) };
+    return res;
+}
+
+// w * 5^q, truncated to 128 bits; high word is exact in its top [bit_precision] bits or all ones below them
+value128_t product_approximation(int q, std::uint64_t w, int bit_precision) {
+    const int idx = 2 * (q - smallest_power_of_ten);
+    const std::uint64_t precision_mask = ~std::uint64_t(0) >> bit_precision;
+
+    value128_t first = full_multiplication(w, powers_of_five_128[idx]);
+    if((first.high & precision_mask) == precision_mask) { /*lower bits may be affected by the rest of 5^q*/
+        value128_t second = full_multiplication(w, powers_of_five_128[idx + 1]);
+        first.low += second.high;
+        if(second.high > first.low)
+            ++first.high;
+    }
+    return first;
+}
+
+// binary exponent of 10^q (floor(log2(10^q))) plus 63
+int power(int q) {
+    return (((152170 + 65536) * q) >> 16) + 63;
+}
+
+#endif
+
+double make_double(std::uint64_t mantissa, int power2) {
+    std::uint64_t bits = mantissa | (std::uint64_t(power2) << mantissa_explicit_bits);
+    double res;
+    std::memcpy(&res, &bits, sizeof(res));
+    return res;
+}
+
+} // namespace
+
+bool eisel_lemire(std::uint64_t w, int q, double& out_val /*out*/) {
+#ifdef __SIZEOF_INT128__
+    if(w == 0 || q < smallest_power_of_ten) {
+        out_val = 0;
+        return true;
+    }
+    if(q > largest_power_of_ten) {
+        out_val = make_double(0, infinite_power);
+        return true;
+    }
+
+    // normalized w, so that product has its highest bit in one of two top positions
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    value128_t product = product_approximation(q, w, mantissa_explicit_bits + 3);
+
+    // truncated power of five may have lost carry into the bits, which decide rounding
+    // Outside of this range of q, the product is not known to be exact enough
+    if(product.low == ~std::uint64_t(0) && (q < -27 || q > 55))
+        return false;
+
+    int upperbit = product.high >> 63;
+    int shift = upperbit + 64 - mantissa_explicit_bits - 3;
+    std::uint64_t mantissa = product.high >> shift;
+    int power2 = power(q) + upperbit - lz - minimum_exponent;
+
+    if(power2 <= 0) { /*subnormal*/
+        if(-power2 + 1 >= 64) {
+            out_val = 0;
+            return true;
+        }
+
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+
+        // rounding up may give the smallest normal number
+        power2 = mantissa < (std::uint64_t(1) << mantissa_explicit_bits) ? 0 : 1;
+        out_val = make_double(mantissa & ~(std::uint64_t(1) << mantissa_explicit_bits), power2);
+        return true;
+    }
+
+    // exactly halfway: round to even, instead of up
+    if(
+        product.low <= 1 && q >= min_exponent_round_to_even && q <= max_exponent_round_to_even &&
+        (mantissa & 3) == 1 && (mantissa << shift) == product.high
+    )
+        mantissa &= ~std::uint64_t(1);
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+
+    // rounding up overflowed mantissa
+    if(mantissa >= (std::uint64_t(2) << mantissa_explicit_bits)) {
+        mantissa = std::uint64_t(1) << mantissa_explicit_bits;
+        ++power2;
+    }
+    mantissa &= ~(std::uint64_t(1) << mantissa_explicit_bits);
+
+    if(power2 >= infinite_power) {
+        mantissa = 0;
+        power2 = infinite_power;
+    }
+
+    out_val = make_double(mantissa, power2);
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace detail
+
+namespace {
+
+// exponent, beyond which any literal is zero or infinity; keeps sum of exponents from overflow
+const int max_exponent_digits_value = 100000;
+
+// 10^k, k <= 22, are exact doubles
+const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// 8 digits at [p] are converted at once (SWAR), if all of them are digits
+bool is_eight_digits(const char *p, std::uint64_t& val /*out*/) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::memcpy(&val, p, sizeof(val));
+    return (((val + 0x4646464646464646) | (val - 0x3030303030303030)) & 0x8080808080808080) == 0;
+#else
+    return false;
+#endif
+}
+
+std::uint32_t parse_eight_digits(std::uint64_t val) {
+    const std::uint64_t mask = 0x000000FF000000FF;
+    const std::uint64_t mul1 = 0x000F424000000064; /*100 + (1000000ULL << 32)*/
+    const std::uint64_t mul2 = 0x0000271000000001; /*1 + (10000ULL << 32)*/
+    val -= 0x3030303030303030;
+    val = (val * 10) + (val >> 8); /*pairs of digits*/
+    val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+    return (std::uint32_t) val;
+}
+
+// Significand of decimal literal: up to 19 significant digits, the rest shifts exponent
+struct significand_t {
+    std::uint64_t w;
+    int exp10;
+    int num_digits;  /*significant, accumulated in w*/
+    bool truncated;  /*non-zero digits were dropped*/
+
+    void append(const char *beg, const char *end, bool is_fraction) {
+        // leading zeros are not significant
+        if(num_digits == 0) {
+            while(beg != end && *beg == '0') {
+                exp10 -= is_fraction;
+                ++beg;
+            }
+        }
+
+        std::uint64_t eight;
+        while(end - beg >= 8 && num_digits + 8 <= 19 && is_eight_digits(beg, eight)) {
+            w = w * 100000000 + parse_eight_digits(eight);
+            num_digits += 8;
+            exp10 -= is_fraction ? 8 : 0;
+            beg += 8;
+        }
+
+        for(; beg != end && num_digits < 19; ++beg) {
+            w = w * 10 + (*beg - '0');
+            ++num_digits;
+            exp10 -= is_fraction;
+        }
+
+        // dropped digits of integer part scale it
+        if(!is_fraction)
+            exp10 += end - beg;
+        for(; beg != end && !truncated; ++beg)
+            truncated = *beg != '0';
+    }
+};
+
+bool is_hex_digit(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+const char *skip_hex_digits(const char *beg, const char *end) {
+    while(beg != end && is_hex_digit(*beg))
+        ++beg;
+    return beg;
+}
+
+// end of exponent [beg] = marker [+|-] digits, or [beg], if there is none; its value is clamped
+const char *parse_exponent(const char *beg, const char *end, char marker, int& out_exp /*out*/) {
+    const char *cur_ptr = beg;
+    if(cur_ptr == end || (*cur_ptr | 0x20) != marker)
+        return beg;
+    ++cur_ptr;
+
+    bool negative = false;
+    if(cur_ptr != end && (*cur_ptr == '+' || *cur_ptr == '-'))
+        negative = *cur_ptr++ == '-';
+
+    const char *digits_end = skip_digits(cur_ptr, end);
+    if(digits_end == cur_ptr)
+        return beg;
+
+    int exp = 0;
+    for(; cur_ptr != digits_end; ++cur_ptr)
+        if(exp < max_exponent_digits_value)
+            exp = exp * 10 + (*cur_ptr - '0');
+
+    out_exp = negative ? -exp : exp;
+    return digits_end;
+}
+
+// strtod on copy of literal, which is not terminated in input
+double parse_fallback(const char *beg, const char *end) {
+    std::string literal(beg, end);
+    return std::strtod(literal.c_str(), NULL);
+}
+
+} // namespace
+
+const char *parse_number(const char *beg, const char *end, double& out_val /*out*/) {
+    if(beg == end || !is_digit(*beg))
+        return beg;
+
+    // hexadecimal literal is converted by strtod, which is exact for it
+    if(*beg == '0' && end - beg > 2 && (beg[1] | 0x20) == 'x' && is_hex_digit(beg[2])) {
+        const char *cur_ptr = skip_hex_digits(beg + 2, end);
+        if(cur_ptr != end && *cur_ptr == '.')
+            cur_ptr = skip_hex_digits(cur_ptr + 1, end);
+
+        int exp;
+        cur_ptr = parse_exponent(cur_ptr, end, 'p', exp);
+        out_val = parse_fallback(beg, cur_ptr);
+        return cur_ptr;
+    }
+
+    significand_t sig = { 0, 0, 0, false };
+
+    const char *int_end = skip_digits(beg, end);
+    sig.append(beg, int_end, false);
+
+    const char *cur_ptr = int_end;
+    if(cur_ptr != end && *cur_ptr == '.') {
+        const char *frac_end = skip_digits(cur_ptr + 1, end);
+        sig.append(cur_ptr + 1, frac_end, true);
+        cur_ptr = frac_end;
+    }
+
+    int exp = 0;
+    cur_ptr = parse_exponent(cur_ptr, end, 'e', exp);
+    int q = sig.exp10 + exp;
+
+    // Clinger's fast path: both w and 10^|q| are exact doubles, so is their product or quotient
+    if(!sig.truncated && sig.w <= (std::uint64_t(1) << 53) && q >= -22 && q <= 22) {
+        double w = (double) sig.w;
+        out_val = q < 0 ? w / exact_powers_of_ten[-q] : w * exact_powers_of_ten[q];
+        return cur_ptr;
+    }
+
+    // dropped digits put value between w and w + 1: both must round the same
+    double val, upper;
+    if(
+        detail::eisel_lemire(sig.w, q, val) &&
+        (!sig.truncated || (detail::eisel_lemire(sig.w + 1, q, upper) && upper == val))
+    ) {
+        out_val = val;
+        return cur_ptr;
+    }
+
+    out_val = parse_fallback(beg, cur_ptr);
+    return cur_ptr;
+}
+
+} // namespace postfix::lexer
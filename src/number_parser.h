@@ -0,0 +1,38 @@
+#ifndef NUMBER_PARSER_H
+#define NUMBER_PARSER_H
+
+/**
+ * Parser of numeric literals
+ *      Decimal literals with exponent: Clinger's fast path, Eisel-Lemire algorithm,
+ *      strtod for the few cases, which they can not decide
+ *      Hexadecimal literals
+*/
+
+#include <cstdint>
+
+namespace postfix::lexer {
+
+// Parses unsigned literal at [beg], correctly rounded to nearest double (as strtod does):
+//      digits [. [digits]] [(e|E) [+|-] digits]
+//      (0x|0X) hex-digits [. [hex-digits]] [(p|P) [+|-] digits]
+// Sign is not part of literal; exponent marker, which is not followed by digits, is not part of it either.
+// Returns end of literal and sets [out_val], or returns [beg], if there is no literal at [beg]
+const char *parse_number(const char *beg, const char *end, double& out_val /*out*/);
+
+namespace detail {
+
+const int smallest_power_of_ten = -342;
+const int largest_power_of_ten = 308;
+
+// 128-bit approximations of 5^q, q in [smallest_power_of_ten, largest_power_of_ten], two words per power
+extern const std::uint64_t powers_of_five_128[];
+
+// w * 10^q, computed by Eisel-Lemire algorithm
+// Returns false, if it can not be decided without more precision
+bool eisel_lemire(std::uint64_t w, int q, double& out_val /*out*/);
+
+} // namespace detail
+
+} // namespace postfix::lexer
+
+#endif
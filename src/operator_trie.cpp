@@ -0,0 +1,91 @@
+#include "operator_trie.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace postfix::detail {
+
+operator_trie_t::operator_trie_t(): max_length(0) {
+    node_t root = { 0, 0, 0, 0 };
+    nodes.push_back(root);
+}
+
+operator_trie_t::operator_trie_t(const util::vector<std::string>& names): max_length(0) {
+    assert(std::is_sorted(names.begin(), names.end()));
+    build(names, 0, names.size(), 0);
+
+    for(int i = 0; i < names.size(); ++i)
+        max_length = std::max(max_length, (int) names[i].size());
+}
+
+int operator_trie_t::build(const util::vector<std::string>& names, int lo, int hi, int depth) {
+    int idx = nodes.size();
+    node_t node = { (int) edges.size(), 0, lo, lo };
+
+    // names, equal to prefix, precede longer ones
+    while(node.last_name < hi && (int) names[node.last_name].size() == depth)
+        ++node.last_name;
+
+    // edges of node are contiguous: they are reserved before children are built
+    for(int i = node.last_name; i < hi; ) {
+        unsigned char c = names[i][depth];
+        edge_t edge = { c, -1 };
+        edges.push_back(edge);
+        ++node.num_edges;
+
+        while(i < hi && (unsigned char) names[i][depth] == c)
+            ++i;
+    }
+    nodes.push_back(node);
+
+    for(int i = node.last_name, e = node.first_edge; i < hi; ++e) {
+        int group_end = i;
+        while(group_end < hi && names[group_end][depth] == names[i][depth])
+            ++group_end;
+
+        int child_idx = build(names, i, group_end, depth + 1);
+        edges[e].child = child_idx;
+        i = group_end;
+    }
+
+    return idx;
+}
+
+int operator_trie_t::child(int node, unsigned char c) const {
+    const edge_t *beg = edges.begin() + nodes[node].first_edge;
+    const edge_t *end = beg + nodes[node].num_edges;
+
+    const edge_t *it = std::lower_bound(beg, end, c, [](const edge_t& edge, unsigned char val) {
+        return edge.c < val;
+    });
+    return it != end && it->c == c ? it->child : -1;
+}
+
+const char *operator_trie_t::match(const char *beg, const char *end, int& first, int& last) const {
+    const char *res = beg;
+    first = last = 0;
+
+    int node = 0;
+    for(const char *cur = beg; cur != end; ) {
+        node = child(node, *cur);
+        if(node == -1)
+            break;
+        ++cur;
+
+        if(nodes[node].first_name != nodes[node].last_name) {
+            res = cur;
+            first = nodes[node].first_name;
+            last = nodes[node].last_name;
+        }
+    }
+
+    return res;
+}
+
+bool operator_trie_t::contains(const std::string& name) const {
+    int first, last;
+    const char *end = name.data() + name.size();
+    return !name.empty() && match(name.data(), end, first, last) == end;
+}
+
+} // namespace postfix::detail
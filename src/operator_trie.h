@@ -0,0 +1,67 @@
+#ifndef OPERATOR_TRIE_H
+#define OPERATOR_TRIE_H
+
+/**
+ * Trie of operator names
+ *      Built once from sorted names, immutable afterwards
+ *      Longest-match lookup without allocation
+*/
+
+#include <string>
+
+#include "util/vector.h"
+
+namespace postfix::detail {
+
+// Trie over sorted array of names, e.g. names of token factories
+//
+// Node of prefix refers to range of names, equal to prefix (names may repeat, e.g. binary and unary "+"),
+// and to its edges: contiguous run of (character, child) pairs, sorted by character.
+// Nodes and edges reside in two flat arrays, thus lookup walks them without allocating
+class operator_trie_t {
+public:
+    operator_trie_t();
+
+    // [names] must be sorted; name names[i] is reported as index i
+    explicit operator_trie_t(const util::vector<std::string>& names);
+
+    // Longest name, which is prefix of [beg, end)
+    // Returns its end and sets [first, last) to indices of names equal to it;
+    // returns [beg] and empty range, if there is no such name
+    const char *match(const char *beg, const char *end, int& first /*out*/, int& last /*out*/) const;
+
+    // true, if [name] is one of names
+    bool contains(const std::string& name) const;
+
+    // length of the longest name: match does not look further than that
+    int get_max_length() const {
+        return max_length;
+    }
+
+private:
+    struct node_t {
+        int first_edge;
+        int num_edges;
+        int first_name; /*names equal to prefix of node*/
+        int last_name;
+    };
+
+    struct edge_t {
+        unsigned char c;
+        int child;
+    };
+
+    util::vector<node_t> nodes; /*root is nodes[0]*/
+    util::vector<edge_t> edges;
+    int max_length;
+
+    // builds node of names [lo, hi), sharing prefix of [depth] characters; returns its index
+    int build(const util::vector<std::string>& names, int lo, int hi, int depth);
+
+    // child of [node] by [c], or -1
+    int child(int node, unsigned char c) const;
+};
+
+} // namespace postfix::detail
+
+#endif
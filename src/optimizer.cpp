@@ -0,0 +1,68 @@
+#include "optimizer.h"
+
+#include "token_builder.h"
+
+#include "util/stack.h"
+
+namespace postfix::optimizer {
+
+util::vector<token_t> fold_constants(util::vector<token_t>& expr) {
+    util::vector<token_t> res;
+
+    // for every value on evaluation stack: is it known number
+    util::vector<bool> is_const;
+    // values of numbers on top of stack, parallel to is_const
+    util::vector<double> values;
+
+    util::stack<double> calc_st;
+
+    for(int i = 0; i < expr.size(); ++i) {
+        token_t& token = expr[i];
+        num_operands_t num_operands = token.get_num_operands();
+
+        if(is_const.size() < num_operands) { /*malformed expression, keep rest as is*/
+            for(; i < expr.size(); ++i)
+                res.push_back(expr[i]);
+            break;
+        }
+
+        // are all operands known; leaf is known, only if it is number (not variable)
+        bool all_const = num_operands > 0 || token.get_name() == token_number::name;
+        for(int j = 1; j <= num_operands; ++j)
+            all_const = all_const && is_const[is_const.size() - j];
+
+        if(!all_const) {
+            for(int j = 0; j < num_operands; ++j) {
+                is_const.pop_back();
+                values.pop_back();
+            }
+
+            res.push_back(token);
+            is_const.push_back(false);
+            values.push_back(0);
+            continue;
+        }
+
+        // calculate token on its operands (numbers push themselves)
+        while(!calc_st.empty())
+            calc_st.pop();
+        for(int j = num_operands; j >= 1; --j)
+            calc_st.push(values[values.size() - j]);
+        token.calc_process(calc_st);
+
+        // operands are the last number tokens of result
+        for(int j = 0; j < num_operands; ++j) {
+            res.pop_back();
+            is_const.pop_back();
+            values.pop_back();
+        }
+
+        res.push_back(num_operands == 0 ? token : builder::number(calc_st.peek()));
+        is_const.push_back(true);
+        values.push_back(calc_st.peek());
+    }
+
+    return res;
+}
+
+} // namespace postfix::optimizer
@@ -0,0 +1,22 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+/**
+ * Optimization passes over converted postfix expression
+*/
+
+#include "token.h"
+
+#include "util/vector.h"
+
+namespace postfix::optimizer {
+
+// Collapses every operator, whose operands are all numbers, into single number
+// Values are computed by tokens themselves (calc_process), so they are exactly
+// the same as evaluation would produce.
+// Malformed part of expression (operator without enough operands) is left untouched
+util::vector<token_t> fold_constants(util::vector<token_t>& expr);
+
+} // namespace postfix::optimizer
+
+#endif
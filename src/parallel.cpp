@@ -0,0 +1,23 @@
+#include "parallel.h"
+
+namespace postfix::parallel {
+
+void convert_and_evaluate(
+    thread_pool_t& pool,
+    const postfix_converter_t& converter,
+    const std::string *inputs,
+    int num_inputs,
+    double *results,
+    const double *values
+) {
+    util::vector<postfix_converter_t> converters;
+    for(int w = 0; w < pool.get_num_workers(); ++w)
+        converters.push_back(converter.clone());
+
+    pool.parallel_for(num_inputs, [&](int worker, int i) {
+        postfix_expr_t expr = converters[worker].convert(inputs[i]);
+        results[i] = values != NULL ? expr.evaluate_at(values) : expr.evaluate();
+    });
+}
+
+} // namespace postfix::parallel
@@ -0,0 +1,32 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ * Parallel batch API
+ *      Conversion and evaluation of many inputs on thread pool
+*/
+
+#include <string>
+
+#include "postfix.h"
+#include "thread_pool.h"
+
+namespace postfix::parallel {
+
+// results[i] = value of inputs[i], for every i < [num_inputs]
+// Inputs are converted by [converter]'s copies, one per worker (converter itself is not thread-safe),
+// so that workers share nothing. Variables of slot v are values[v]; [values] may be NULL,
+// if inputs have no variables
+// Throws exception of the first input (in input order), which failed to convert or evaluate
+void convert_and_evaluate(
+    thread_pool_t& pool,
+    const postfix_converter_t& converter,
+    const std::string *inputs,
+    int num_inputs,
+    double *results,
+    const double *values = NULL
+);
+
+} // namespace postfix::parallel
+
+#endif
@@ -0,0 +1,307 @@
+#include "polynomial.h"
+
+#include <cmath>
+#include <string>
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+const int not_polynomial = -2;
+const int constant_base = -1;
+
+// Polynomial in node [base]: sum of coeffs[k] * base^k
+struct polynomial_t {
+    int base; /*constant_base, if polynomial is constant*/
+    util::vector<double> coeffs;
+};
+
+bool compatible(const polynomial_t& a, const polynomial_t& b) {
+    return a.base == constant_base || b.base == constant_base || a.base == b.base;
+}
+
+int common_base(const polynomial_t& a, const polynomial_t& b) {
+    return a.base == constant_base ? b.base : a.base;
+}
+
+int degree(const polynomial_t& p) {
+    return p.coeffs.size() - 1;
+}
+
+void trim(polynomial_t& p) {
+    while(p.coeffs.size() > 1 && p.coeffs[p.coeffs.size() - 1] == 0)
+        p.coeffs.pop_back();
+}
+
+polynomial_t make_constant(double value) {
+    polynomial_t res;
+    res.base = constant_base;
+    res.coeffs.push_back(value);
+    return res;
+}
+
+// [node] itself, as polynomial of degree 1
+polynomial_t make_atom(int node) {
+    polynomial_t res;
+    res.base = node;
+    res.coeffs.push_back(0);
+    res.coeffs.push_back(1);
+    return res;
+}
+
+// a + sign * b
+polynomial_t add(const polynomial_t& a, const polynomial_t& b, double sign) {
+    polynomial_t res;
+    res.base = common_base(a, b);
+    for(int k = 0; k < a.coeffs.size() || k < b.coeffs.size(); ++k) {
+        double ak = k < a.coeffs.size() ? a.coeffs[k] : 0;
+        double bk = k < b.coeffs.size() ? b.coeffs[k] : 0;
+        res.coeffs.push_back(ak + sign * bk);
+    }
+
+    trim(res);
+    return res;
+}
+
+polynomial_t multiply(const polynomial_t& a, const polynomial_t& b) {
+    polynomial_t res;
+    res.base = common_base(a, b);
+    res.coeffs = util::vector<double>(a.coeffs.size() + b.coeffs.size() - 1, 0.0);
+    for(int i = 0; i < a.coeffs.size(); ++i)
+        for(int j = 0; j < b.coeffs.size(); ++j)
+            res.coeffs[i + j] += a.coeffs[i] * b.coeffs[j];
+
+    trim(res);
+    return res;
+}
+
+polynomial_t scale(const polynomial_t& a, double factor) {
+    return multiply(a, make_constant(factor));
+}
+
+bool is_constant(const polynomial_t& p) {
+    return p.base == constant_base;
+}
+
+// Polynomial, computed by [node] from polynomials of its children,
+// or base == not_polynomial, if operator does not preserve polynomials
+polynomial_t combine(const dag_node_t& node, const util::vector<polynomial_t>& polys) {
+    polynomial_t none;
+    none.base = not_polynomial;
+
+    const polynomial_t *args[max_node_children];
+    for(int j = 0; j < node.num_children; ++j) {
+        args[j] = &polys[node.children[j]];
+        if(args[j]->base == not_polynomial)
+            return none;
+    }
+
+    for(int j = 1; j < node.num_children; ++j)
+        if(!compatible(*args[0], *args[j]) || !compatible(*args[j - 1], *args[j]))
+            return none;
+
+    switch(node.op) {
+    case op_t::add:
+        return add(*args[0], *args[1], 1);
+    case op_t::sub:
+        return add(*args[0], *args[1], -1);
+    case op_t::neg:
+        return scale(*args[0], -1);
+
+    case op_t::mul:
+        if(degree(*args[0]) + degree(*args[1]) > max_polynomial_degree)
+            return none;
+        return multiply(*args[0], *args[1]);
+
+    case op_t::fma:
+        if(degree(*args[0]) + degree(*args[1]) > max_polynomial_degree)
+            return none;
+        return add(multiply(*args[0], *args[1]), *args[2], 1);
+
+    case op_t::div: { /*by constant*/
+        if(!is_constant(*args[1]) || !std::isnormal(1.0 / args[1]->coeffs[0]))
+            return none;
+        return scale(*args[0], 1.0 / args[1]->coeffs[0]);
+    }
+
+    case op_t::pow: { /*to small natural constant*/
+        if(!is_constant(*args[1]))
+            return none;
+
+        double e = args[1]->coeffs[0];
+        if(e < 1 || e != std::floor(e) || degree(*args[0]) * e > max_polynomial_degree)
+            return none;
+
+        polynomial_t res = *args[0];
+        for(int k = 1; k < (int) e; ++k)
+            res = multiply(res, *args[0]);
+        return res;
+    }
+
+    default:
+        return none;
+    }
+}
+
+// Operators of polynomial [root] in [base], as it is written in [dag]
+// [stamp] marks visited nodes with [root]
+int count_operators(
+    const expr_dag_t& dag,
+    int root, int base,
+    util::vector<int>& stamp
+) {
+    int num = 0;
+    util::vector<int> pending;
+    pending.push_back(root);
+    stamp[root] = root;
+
+    while(!pending.empty()) {
+        int idx = pending[pending.size() - 1];
+        pending.pop_back();
+        ++num;
+
+        const dag_node_t& node = dag.get_node(idx);
+        for(int j = 0; j < node.num_children; ++j) {
+            int child = node.children[j];
+            if(stamp[child] == root || child == base || dag.get_node(child).op == op_t::push_const)
+                continue;
+
+            stamp[child] = root;
+            pending.push_back(child);
+        }
+    }
+
+    return num;
+}
+
+// Horner form of [coeffs] in node [x] of [out]
+// With [out] == NULL only counts operators
+int horner(expr_dag_t *out, const util::vector<double>& coeffs, int x, int& num_ops /*out*/) {
+    num_ops = 0;
+
+    // accumulator is either node, or constant (acc < 0)
+    int acc = -1;
+    double acc_value = coeffs[coeffs.size() - 1];
+
+    for(int k = coeffs.size() - 2; k >= 0; --k) {
+        double ck = coeffs[k];
+        int ck_node = out && ck != 0 ? out->make_const(ck) : -1;
+
+        if(acc < 0 && acc_value == 1) { /*x + ck*/
+            num_ops += ck != 0;
+            if(out)
+                acc = ck != 0 ? out->make_binary(op_t::add, x, ck_node) : x;
+            else
+                acc = 0;
+            continue;
+        }
+
+        ++num_ops;
+        if(!out) {
+            acc = 0;
+            continue;
+        }
+
+        int acc_node = acc < 0 ? out->make_const(acc_value) : acc;
+        if(ck == 0) {
+            acc = out->make_binary(op_t::mul, acc_node, x);
+        } else {
+            int children[3] = { acc_node, x, ck_node };
+            acc = out->make_node(op_t::fma, 3, children);
+        }
+    }
+
+    return acc;
+}
+
+} // namespace
+
+
+expr_dag_t rewrite_polynomials(const expr_dag_t& dag, util::vector<rewrite_t> *rewrites) {
+    expr_dag_t res(dag.hash_consing());
+    if(dag.get_root() < 0)
+        return res;
+
+    util::vector<polynomial_t> polys;
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+
+        if(node.op == op_t::push_const) {
+            polys.push_back(make_constant(node.value));
+            continue;
+        }
+
+        polynomial_t poly = combine(node, polys);
+        // nodes, which are not polynomials, are inputs of enclosing polynomials
+        polys.push_back(poly.base == not_polynomial ? make_atom(i) : poly);
+    }
+
+    // Polynomial is computed as whole, if its value is used outside of it:
+    // by root or by parent, which is not part of the same polynomial
+    util::vector<int> uses = dag.count_uses();
+    util::vector<bool> is_whole(dag.size(), false);
+    is_whole[dag.get_root()] = true;
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+        if(uses[i] == 0)
+            continue;
+
+        bool is_inner = polys[i].base != i && !is_constant(polys[i]);
+        for(int j = 0; j < node.num_children; ++j) {
+            int child = node.children[j];
+            if(!is_inner || polys[child].base != polys[i].base)
+                is_whole[child] = true;
+        }
+    }
+
+    util::vector<int> node_map(dag.size(), -1);
+    util::vector<int> stamp(dag.size(), -1);
+
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+        const polynomial_t& poly = polys[i];
+
+        if(node.op == op_t::push_const) {
+            node_map[i] = res.make_const(node.value);
+            continue;
+        }
+        if(node.op == op_t::load_var) {
+            node_map[i] = res.make_var((std::uint32_t) node.value);
+            continue;
+        }
+
+        // non-constant polynomial of degree >= 1, which is not input itself
+        if(is_whole[i] && poly.base >= 0 && poly.base != i && degree(poly) >= 1) {
+            int num_ops;
+            horner(NULL, poly.coeffs, -1, num_ops);
+            int num_written = count_operators(dag, i, poly.base, stamp);
+
+            if(num_ops < num_written) {
+                node_map[i] = horner(&res, poly.coeffs, node_map[poly.base], num_ops);
+
+                if(rewrites) {
+                    rewrite_t rewrite = {
+                        "polynomial_to_horner",
+                        "polynomial of degree " + std::to_string(degree(poly)) +
+                        " (" + std::to_string(num_written) + " operators) -> Horner form (" +
+                        std::to_string(num_ops) + " operators)"
+                    };
+                    rewrites->push_back(rewrite);
+                }
+                continue;
+            }
+        }
+
+        int children[max_node_children];
+        for(int j = 0; j < node.num_children; ++j)
+            children[j] = node_map[node.children[j]];
+        node_map[i] = res.make_node(node.op, node.num_children, children);
+    }
+
+    res.set_root(node_map[dag.get_root()]);
+    return res;
+}
+
+} // namespace postfix::optimizer
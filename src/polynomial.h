@@ -0,0 +1,31 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+/**
+ * Polynomial recognition over expression DAG
+ *      Subexpressions, which are polynomials in single input, are found
+ *      and rewritten into Horner form on fma
+*/
+
+#include "expr_dag.h"
+
+#include "util/vector.h"
+
+namespace postfix::optimizer {
+
+// Polynomials of higher degree are left as they are
+const int max_polynomial_degree = 16;
+
+// Returns [dag], where polynomials in single non-constant input x,
+// e.g. 3*x*x*x + 2*x*x - x + 7, are computed as fma(fma(fma(3, x, 2), x, -1), x, 7)
+// Coefficients are gathered at compile time and every step is rounded once,
+// so result may differ in last bits: pass is meant for relaxed precision.
+// Terms, whose coefficients cancel, are removed (x*x - x*x + x -> x), and Horner form
+// overflows differently, so that infinite or NaN input may give another, even finite, result.
+// Polynomial is rewritten, only if Horner form needs fewer operators.
+// Every rewrite is appended to [rewrites], if it is not NULL
+expr_dag_t rewrite_polynomials(const expr_dag_t& dag, util::vector<rewrite_t> *rewrites /*out*/);
+
+} // namespace postfix::optimizer
+
+#endif
@@ -1,12 +1,14 @@
 #include "postfix.h"
 
 #include <cstring>
-#include <numeric>
 
 #include "token.h"
 #include "token_concrete.h"
 #include "token_factory.h"
 #include "token_builder.h"
+#include "bytecode.h"
+#include "lexer.h"
+#include "number_parser.h"
 
 #include "util/vector.h"
 #include "util/stack.h"
@@ -18,42 +20,14 @@ namespace detail {
 
 const char *
 postfix_converter_impl_t::to_number(const char *beg, const char *end, double &out_val /*out*/) {
-    const char *cur_ptr = beg;
-
-    while(cur_ptr != end && isspace(*cur_ptr))
-        cur_ptr++;
-
-    const char *start_after_spaces = cur_ptr;
-    double res_val = 0;
-    while(cur_ptr != end && isdigit(*cur_ptr)) {
-        res_val *= 10;
-        res_val += (*cur_ptr - '0');
-        ++cur_ptr;
-    }
+    const char *cur_ptr = lexer::skip_spaces(beg, end);
 
     // return to same pos, signaling that no number was found
-    if(cur_ptr == start_after_spaces)
+    const char *num_end = lexer::parse_number(cur_ptr, end, out_val);
+    if(num_end == cur_ptr)
         return beg;
 
-    out_val = res_val;
-    if(cur_ptr == end || cur_ptr == beg)
-        return cur_ptr;
-    
-    if(*cur_ptr != '.')
-        return cur_ptr;
-    cur_ptr++; // move 1 position, after dot
-
-    res_val = 0;
-    double dividor = 1;
-    while(cur_ptr != end && isdigit(*cur_ptr)) {
-        dividor /= 10;
-        res_val += (*cur_ptr - '0') * dividor;
-        ++cur_ptr;
-    }
-
-    out_val += res_val;
-
-    return cur_ptr;
+    return num_end;
 }
 
 const char *
@@ -66,65 +40,69 @@ postfix_converter_impl_t::to_operator(
     if(beg == end)
         return beg;
 
-    while(beg != end && isspace(*beg))
-        beg++;
+    const char *cur_ptr = lexer::skip_spaces(beg, end);
 
-    std::string op_name; // potential operation name
-    util::vector<token_t> found_candidate_tokens;
-    
-    util::vector<int> candidates(factory_names.size()); // Ideal type would be unordered_set
-    std::iota(candidates.begin(), candidates.end(), 0);
-    int comp_val;
-    int found_idx = -1;
-
-    while(!candidates.empty() && beg != end) {
-        // Increment potential operation's name, so that to find exact match
-        op_name += *beg;
-        beg++;
-
-        // Look through candidates and remove some of them
-        // Candidates can be removed easily, as their prefix does not match
-        for(
-            int *cand_beg = candidates.begin(); 
-            cand_beg != candidates.end();
-            cand_beg++
-        ) {
-            if( (comp_val = factory_names[*cand_beg].compare(op_name)) == 0 ) { /*Exact match*/
-                found_idx = *cand_beg;
-                // push into candidates_of_same_name,
-                found_candidate_tokens.push_back( factories[found_idx].build() );
-                continue;
-            }
-            else if (comp_val < 0) { /*not equal prefix*/
-                candidates.erase(cand_beg);
-                --cand_beg;
-            }
-        }
+    // factories of the same name are adjacent, e.g. binary and unary minus
+    int first, last;
+    const char *name_end = operators.match(cur_ptr, end, first, last);
+    if(name_end == cur_ptr)
+        return beg;
+
+    for(int i = first; i < last; ++i)
+        candidate_tokens.push_back( factories[i].build() );
+
+    return name_end;
+}
+
+static bool is_identifier_char(char c, bool is_first) {
+    unsigned classes = lexer::classes_of(c);
+    return (classes & lexer::identifier) && !(is_first && (classes & lexer::digit));
+}
 
-        // First found matching operator is returned
-        if(!found_candidate_tokens.empty()) {
-            // Append candidates to *out* candidates
-            // TODO: 
-            // Should consider rewriting this code
-            // So it would start with preliminary candidates.clear()
-            // Thus, saving memory
-            std::copy(
-                found_candidate_tokens.begin(),
-                found_candidate_tokens.end(),
-                std::back_inserter(candidate_tokens)
-            );
-
-            return beg;
+const char *
+postfix_converter_impl_t::to_variable(
+    const char *beg,
+    const char *end,
+    util::vector<token_t>& candidate_tokens /*out*/
+) {
+    const char *cur_ptr = lexer::skip_spaces(beg, end);
+
+    // whole identifier is read, so that e.g. variable "expo" is not taken for function exp
+    const char *name_beg = cur_ptr;
+    if(cur_ptr == end || !is_identifier_char(*cur_ptr, true))
+        return beg;
+    cur_ptr = lexer::skip(cur_ptr, end, lexer::identifier);
+
+    for(int i = 0; i < variable_names.size(); ++i) {
+        const std::string& name = variable_names[i];
+        if(name.size() == (std::size_t) (cur_ptr - name_beg) && name.compare(0, name.size(), name_beg, name.size()) == 0) {
+            candidate_tokens.push_back(builder::variable(name, i));
+            return cur_ptr;
         }
-            
     }
 
-    // No candidates were found
-    // return with no candidates being appended
-
+    // not a variable, e.g. function
     return beg;
 }
 
+std::uint32_t postfix_converter_impl_t::add_variable(const std::string& name) {
+    bool is_identifier = !name.empty();
+    for(std::size_t i = 0; i < name.size(); ++i)
+        is_identifier = is_identifier && is_identifier_char(name[i], i == 0);
+
+    if(!is_identifier)
+        throw std::invalid_argument("postfix_converter_t::add_variable: " + name + " is not identifier");
+
+    if(
+        operators.contains(name) ||
+        std::find(variable_names.begin(), variable_names.end(), name) != variable_names.end()
+    )
+        throw std::invalid_argument("postfix_converter_t::add_variable: name " + name + " is already taken");
+
+    variable_names.push_back(name);
+    return variable_names.size() - 1;
+}
+
 const char*
 postfix_converter_impl_t::get_token_candidates(
     const char* beg,
@@ -140,6 +118,12 @@ postfix_converter_impl_t::get_token_candidates(
         return iter;
     }
 
+    // is it variable?
+    iter = to_variable(beg, end, candidate_tokens);
+    if(iter != beg) {
+        return iter;
+    }
+
     // is it one of operator? (Generally - token)
     iter = to_operator(beg, end, candidate_tokens);
     if(iter != beg) {
@@ -147,13 +131,13 @@ postfix_converter_impl_t::get_token_candidates(
     }
 
     // It is not one of the operators
-    std::string err_msg = "postfix_converter_impl_t: could not convert to token" + std::string(beg);
+    std::string err_msg = "postfix_converter_impl_t: could not convert to token" + std::string(beg, end);
     throw std::runtime_error(err_msg);
     return NULL;
 }
 
 // Find token, such that it matches with previous token
-inline token_t prune_tokens(
+token_t prune_tokens(
     token_t& prev_token,
     util::vector<token_t>& candidate_tokens
 ) {
@@ -195,48 +179,429 @@ inline token_t prune_tokens(
 // if 2 conseq operators, just push (??? not valid statement anymore?)
 
 postfix_expr_t
-postfix_converter_t::convert(const std::string& input) {
-    util::stack< token_t > st;
+postfix_converter_t::convert(std::string_view input) {
+    return convert(input.data(), input.data() + input.size());
+}
+
+postfix_expr_t
+postfix_converter_t::convert(const char *beg, const char *end) {
     postfix_expr_t postfix;
+    convert_tokens(beg, end, postfix.expr);
 
-    // start and end of postfix expr
-    std::string edited_input = std::string("(") + input + std::string(")");
+    postfix.num_variables = impl.get_variables().size();
+    postfix.compile(options);
 
-    const char 
-        *beg = edited_input.begin().base(),
-        *end = edited_input.end().base();
-    
+    return postfix;
+}
 
+void postfix_converter_t::convert_tokens(
+    const char *beg,
+    const char *end,
+    util::vector<token_t>& expr /*out*/,
+    const char *mark,
+    int *mark_size /*out*/
+) {
+    util::stack< token_t > st;
     util::vector<token_t> candidate_tokens;
     token_t cur_token;
     token_conversion_ctx ctx;
     
     // left_parenthesis can be placed after left_parenthesis
     token_t prev_token = builder::left_parenthesis();
-    while(beg != end) {
-        // clear candidate tokens, thus reusing alloc mem
-        candidate_tokens.clear();
-        beg = impl.get_token_candidates(beg, end, candidate_tokens); /*move beg ptr*/
-        
+
+    auto place_token = [&]() {
         cur_token = detail::prune_tokens(prev_token, candidate_tokens); /*prune tokens by prev_token*/
 
         // apply token_specific_logic that affects context
         cur_token.influence_ctx(ctx);
         
         // push into expr
-        cur_token.expr_push(postfix.expr, st);
+        cur_token.expr_push(expr, st);
         prev_token = cur_token;
+    };
+
+    // start and end of postfix expr: input is enclosed in parentheses as tokens,
+    // its text is not copied
+    candidate_tokens.push_back(builder::left_parenthesis());
+    place_token();
+
+    for(beg = lexer::skip_spaces(beg, end); beg != end; beg = lexer::skip_spaces(beg, end)) {
+        const char *token_beg = beg;
+
+        // clear candidate tokens, thus reusing alloc mem
+        candidate_tokens.clear();
+        beg = impl.get_token_candidates(beg, end, candidate_tokens); /*move beg ptr*/
+        place_token();
+
+        if(mark != NULL && token_beg <= mark && mark < beg)
+            *mark_size = expr.size();
     }
 
+    candidate_tokens.clear();
+    candidate_tokens.push_back(builder::right_paranthesis());
+    place_token();
+
     // check if context is valid
     if(!ctx.is_valid())
         throw std::logic_error("invalid parenthesis"); /*might add reason method to ctx*/
+}
+
+namespace {
+
+// Parenthesis depth of block of input: depth change over it and the lowest depth within it
+struct depth_summary_t {
+    int change;
+    int lowest;
+};
+
+// character [c] may end operand: number, variable or parenthesized expression
+bool is_operand_end(char c) {
+    return c == '.' || c == ')' || detail::is_identifier_char(c, false);
+}
+
+// s[pos] is exponent marker of numeric literal, e.g. of 1.5e-3, thus sign after it is not operator
+bool is_exponent_marker(const char *s, int pos) {
+    char marker = s[pos] | 0x20;
+    if(marker != 'e' && marker != 'p')
+        return false;
+
+    // literal starts with digit, identifier does not
+    int first = pos;
+    while(first > 0 && (lexer::classes_of(s[first - 1]) & (lexer::identifier | lexer::dot)))
+        --first;
+    return lexer::is_digit(s[first]);
+}
+
+// Top-level binary + and - of [input], found in [num_blocks] blocks on [pool]
+// Returns false, if input is not split: parentheses are unbalanced or there is top-level comma
+bool find_top_level_splits(
+    std::string_view input,
+    parallel::thread_pool_t& pool,
+    util::vector<int>& splits /*out*/
+) {
+    const int n = input.size();
+    const int num_blocks = pool.get_num_workers() * 4;
+    const int block_size = (n + num_blocks - 1) / num_blocks;
+    const char *s = input.data();
+
+    // parallel prefix sum of depth changes: summary of every block, scan over blocks, then blocks again
+    util::vector<depth_summary_t> summaries(num_blocks);
+    pool.parallel_for(num_blocks, [&](int, int b) {
+        depth_summary_t res = { 0, 0 };
+        for(int i = b * block_size, end = std::min(n, i + block_size); i < end; ++i) {
+            res.change += (s[i] == '(') - (s[i] == ')');
+            res.lowest = std::min(res.lowest, res.change);
+        }
+        summaries[b] = res;
+    });
+
+    util::vector<int> block_depth(num_blocks); /*depth before block*/
+    int depth = 0;
+    for(int b = 0; b < num_blocks; ++b) {
+        block_depth[b] = depth;
+        if(depth + summaries[b].lowest < 0)
+            return false;
+        depth += summaries[b].change;
+    }
+    if(depth != 0)
+        return false;
+
+    util::vector< util::vector<int> > block_splits(num_blocks);
+    util::vector<char> has_comma(num_blocks, false);
+    pool.parallel_for(num_blocks, [&](int, int b) {
+        int depth = block_depth[b];
+        for(int i = b * block_size, end = std::min(n, i + block_size); i < end; ++i) {
+            depth += (s[i] == '(') - (s[i] == ')');
+            if(depth != 0)
+                continue;
+
+            if(s[i] == ',') {
+                has_comma[b] = true;
+            } else if(s[i] == '+' || s[i] == '-') {
+                // binary operator follows operand, unary one follows parenthesis or operator
+                int prev = i - 1;
+                while(prev >= 0 && lexer::is_space(s[prev]))
+                    --prev;
+                if(prev >= 0 && is_operand_end(s[prev]) && !is_exponent_marker(s, prev))
+                    block_splits[b].push_back(i);
+            }
+        }
+    });
+
+    for(int b = 0; b < num_blocks; ++b) {
+        if(has_comma[b])
+            return false;
+        for(int k = 0; k < block_splits[b].size(); ++k)
+            splits.push_back(block_splits[b][k]);
+    }
+
+    return true;
+}
+
+} // namespace
+
+postfix_expr_t
+postfix_converter_t::convert_parallel(std::string_view input, parallel::thread_pool_t& pool, int min_chunk_size) {
+    const int n = input.size();
+    min_chunk_size = std::max(1, min_chunk_size);
+    // chunks would only add overhead
+    if(n < 2 * min_chunk_size || pool.get_num_workers() < 2)
+        return convert(input);
+
+    util::vector<int> splits;
+    if(!find_top_level_splits(input, pool, splits))
+        return convert(input);
+
+    // operators between chunks: chunk k is [bounds[k] + 1, bounds[k + 1]), the first one starts at 0
+    // first_op[k] is the first top-level operator within chunk k, if any
+    util::vector<int> bounds, first_op;
+    bounds.push_back(-1);
+    first_op.push_back(-1);
+    for(int k = 0; k < splits.size(); ++k) {
+        if(splits[k] - (bounds[bounds.size() - 1] + 1) < min_chunk_size || n - splits[k] - 1 < min_chunk_size) {
+            if(first_op[first_op.size() - 1] == -1)
+                first_op[first_op.size() - 1] = splits[k];
+            continue;
+        }
+
+        // chunk must start with token, which may follow binary operator
+        // (unary sign or closing parenthesis may follow only opening one)
+        int first = splits[k] + 1;
+        while(first < n && lexer::is_space(input[first]))
+            ++first;
+        if(first == n || input[first] == '+' || input[first] == '-' || input[first] == ')')
+            continue;
+
+        bounds.push_back(splits[k]);
+        first_op.push_back(-1);
+    }
+    bounds.push_back(n);
+
+    const int num_chunks = bounds.size() - 1;
+    if(num_chunks < 2)
+        return convert(input);
+
+    util::vector<postfix_converter_t> converters;
+    for(int w = 0; w < pool.get_num_workers(); ++w)
+        converters.push_back(clone());
+
+    // postfix of chunk and size of postfix of its first term
+    util::vector< util::vector<token_t> > fragments(num_chunks);
+    util::vector<int> first_term(num_chunks);
+    try {
+        pool.parallel_for(num_chunks, [&](int worker, int k) {
+            const char *beg = input.data() + bounds[k] + 1, *end = input.data() + bounds[k + 1];
+            const char *mark = first_op[k] != -1 ? input.data() + first_op[k] : NULL;
+
+            converters[worker].convert_tokens(beg, end, fragments[k], mark, &first_term[k]);
+            if(mark == NULL)
+                first_term[k] = fragments[k].size();
+        });
+    } catch(const std::exception&) {
+        // input is invalid: serial conversion reports it
+        return convert(input);
+    }
+
+    // a + b - c is a b + c -: operators are left-associative and of the lowest precedence,
+    // so that operator before chunk follows the first term of chunk
+    postfix_expr_t postfix;
+    postfix.expr = fragments[0];
+    for(int k = 1; k < num_chunks; ++k) {
+        const util::vector<token_t>& fragment = fragments[k];
+        for(int i = 0; i < fragment.size(); ++i) {
+            if(i == first_term[k])
+                postfix.expr.push_back(input[bounds[k]] == '+' ? builder::plus() : builder::minus());
+            postfix.expr.push_back(fragment[i]);
+        }
+        if(first_term[k] == fragment.size())
+            postfix.expr.push_back(input[bounds[k]] == '+' ? builder::plus() : builder::minus());
+    }
+
+    postfix.num_variables = impl.get_variables().size();
+    postfix.compile(options);
 
     return postfix;
 }
 
+postfix_converter_t postfix_converter_t::clone() const {
+    postfix_converter_t res;
+    res.set_options(options);
+
+    const util::vector<std::string>& variables = get_variables();
+    for(int i = 0; i < variables.size(); ++i)
+        res.add_variable(variables[i]);
+
+    return res;
+}
+
+void postfix_expr_t::compile(const compile_options_t& options) {
+    if(options.constant_folding)
+        expr = optimizer::fold_constants(expr);
+
+    program = bytecode::program_t();
+    rewrites.clear();
+
+    for(int i = 0; i < expr.size(); ++i)
+        expr[i].compile(program);
+
+    // passes over expression DAG
+    optimizer::expr_dag_t dag;
+    if(
+        (options.common_subexpressions || options.strength_reduction || options.scheduling) &&
+        optimizer::expr_dag_t::from_program(program, options.common_subexpressions, dag)
+    ) {
+        if(options.strength_reduction)
+            dag = optimizer::reduce_strength(dag, options.relaxed_precision, &rewrites);
+        if(options.polynomials && options.relaxed_precision)
+            dag = optimizer::rewrite_polynomials(dag, &rewrites);
+        if(options.reassociation && options.relaxed_precision)
+            dag = optimizer::reassociate(dag, &rewrites);
+
+        if(options.scheduling) {
+            util::vector<bool> reversed = optimizer::schedule_operands(dag);
+            program = dag.to_program(&reversed);
+        } else {
+            program = dag.to_program();
+        }
+    }
+
+    program = bytecode::fuse_superinstructions(program, options.superinstructions);
+
+    // batch evaluation is optional, its blocks are allocated by the first one
+    batch = simd::batch_program_t();
+    batch_st = util::vector<double>();
+
+    // so is parallel evaluation, program is split by the first one
+    subtrees = parallel::subtree_program_t();
+    parallel_task_size = options.parallel_task_size;
+    is_split = false;
+
+    prepare_backend();
+}
+
+void postfix_expr_t::set_backend(backend_t new_backend) {
+    backend = new_backend;
+    prepare_backend();
+}
+
+void postfix_expr_t::prepare_backend() {
+    threaded = bytecode::threaded_program_t();
+    registers = bytecode::register_program_t();
+    native = jit::jit_program_t();
+    packed = simd::slp_program_t();
+
+    switch(backend) {
+    case backend_t::threaded:
+        threaded = bytecode::threaded_program_t(program);
+        break;
+    case backend_t::register_vm:
+        registers = bytecode::register_program_t(program);
+        break;
+    case backend_t::jit:
+        native = jit::jit_program_t(program);
+        break;
+    case backend_t::slp:
+        packed = simd::slp_program_t(program);
+        break;
+    case backend_t::switch_dispatch:
+        break;
+    }
+
+    // stack depth is known, so allocate it once
+    eval_st = util::vector<double>(get_scratch_size());
+}
+
 double postfix_expr_t::evaluate() {
-    util::stack<double> val_st;
+    if(program.get_num_variables() > 0)
+        throw std::logic_error("postfix_expr_t::evaluate(): expression has variables, use evaluate_at");
+
+    return evaluate(eval_st.begin());
+}
+
+double postfix_expr_t::evaluate_at(const double *values) {
+    std::copy(values, values + program.get_num_variables(), eval_st.begin() + get_variables_offset());
+    return evaluate(eval_st.begin());
+}
+
+double postfix_expr_t::evaluate_parallel(parallel::thread_pool_t& pool, const double *values) {
+    program.check();
+    if(program.get_num_variables() > 0 && values == NULL)
+        throw std::logic_error("postfix_expr_t::evaluate_parallel(): expression has variables, their values are required");
+
+    prepare_subtrees();
+    if(!subtrees.split())
+        return values != NULL ? evaluate_at(values) : evaluate();
+
+    return subtrees.run(pool, values);
+}
+
+void postfix_expr_t::prepare_subtrees() {
+    if(is_split)
+        return;
+
+    if(parallel_task_size > 0)
+        subtrees = parallel::subtree_program_t(program, parallel_task_size);
+    is_split = true;
+}
+
+void postfix_expr_t::prepare_batch() {
+    if(!batch.empty())
+        return;
+
+    batch = simd::batch_program_t(program);
+    batch_st = util::vector<double>(batch.get_scratch_size());
+}
+
+void postfix_expr_t::evaluate_batch(const double *const *columns, int num_rows, double *results) {
+    program.check();
+    if(num_rows <= 0)
+        return;
+
+    prepare_batch();
+    batch.run(columns, num_rows, results, batch_st.begin());
+}
+
+void postfix_expr_t::evaluate_batch(const simd::binding_t *bindings, int num_rows, double *results) {
+    program.check();
+    if(num_rows <= 0)
+        return;
+
+    prepare_batch();
+    batch.run(bindings, num_rows, results, batch_st.begin());
+}
+
+double postfix_expr_t::evaluate(double *scratch) const {
+    program.check();
+
+    switch(backend) {
+    case backend_t::threaded:
+        return threaded.run(scratch);
+    case backend_t::register_vm:
+        // programs, which do not fit register file, stay on stack machine
+        if(registers.lowered())
+            return registers.run(scratch);
+        break;
+    case backend_t::jit:
+        // JIT is unavailable on this platform or for this program
+        if(native.compiled())
+            return native.run(scratch);
+        break;
+    case backend_t::slp:
+        if(packed.packed())
+            return packed.run(scratch);
+        break;
+    case backend_t::switch_dispatch:
+        break;
+    }
+
+    return bytecode::interpret(program, scratch);
+}
+
+double postfix_expr_t::evaluate_tokens() {
+    util::stack<double>& val_st = token_st;
+    // reuse memory of previous evaluation
+    while(!val_st.empty())
+        val_st.pop();
     
     for(int i = 0; i < expr.size(); ++i)
         expr[i].calc_process(val_st);
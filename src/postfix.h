@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <string>
+#include <string_view>
 
 #include <iterator>
 
@@ -10,6 +11,22 @@
 #include "token_concrete.h"
 #include "token_factory.h"
 #include "token_builder.h"
+#include "operator_trie.h"
+#include "bytecode.h"
+#include "register_vm.h"
+#include "superinstructions.h"
+#include "jit.h"
+#include "optimizer.h"
+#include "expr_dag.h"
+#include "strength_reduction.h"
+#include "polynomial.h"
+#include "reassociation.h"
+#include "scheduling.h"
+#include "simd.h"
+#include "slp.h"
+#include "batch.h"
+#include "thread_pool.h"
+#include "subtrees.h"
 
 #include "util/vector.h"
 #include "util/stack.h"
@@ -27,7 +44,10 @@ public:
         std::initializer_list<
             token_t
         > list
-    ) {
+    ): postfix_converter_impl_t(util::vector<token_t>(list)) {}
+
+    // converter of [tokens], e.g. generated table of functions
+    explicit postfix_converter_impl_t(const util::vector<token_t>& list) {
         std::transform(
             list.begin(), list.end(),
             std::back_inserter(factories), make_token_factory);
@@ -36,6 +56,7 @@ public:
             factories.begin(), factories.end(), 
             std::back_inserter(factory_names), get_factory_name
         );
+        operators = operator_trie_t(factory_names);
     }
 
     const char *
@@ -45,14 +66,40 @@ public:
         util::vector<token_t>& candidate_tokens /*out*/
     );
 
+    // Declare variable [name], returns its slot
+    // Throws, if name is not identifier, is taken by function or is already declared
+    std::uint32_t add_variable(const std::string& name);
+
+    const util::vector<std::string>& get_variables() const {
+        return variable_names;
+    }
+
+    // characters, which get_token_candidates may examine after run of identifier characters and dots
+    // at start of token (e.g. sign and digit of exponent), or after start of operator
+    int get_max_lookahead() const {
+        return std::max(3, operators.get_max_length());
+    }
+
 private:
     util::vector< std::string > factory_names;
     util::vector< token_factory > factories;
+    operator_trie_t operators; /*of factory_names*/
+    util::vector< std::string > variable_names; /*indexed by slot*/
+
+    // Identifier, which is declared variable
+    const char *
+    to_variable(
+        const char *beg,
+        const char *end,
+        util::vector<token_t>& candidate_tokens /*out*/
+    );
     
     // Minus sign is not supported. It is retrieved as separate operator
+    // Exponent and hexadecimal literals are supported (see lexer::parse_number)
     const char *
     to_number(const char *beg, const char *end, double &out_val /*out*/);
 
+    // Longest name of factory, e.g. function name, found without allocation
     const char *
     to_operator(
         const char *beg,
@@ -82,16 +129,180 @@ private:
 };
 
 
+// Find token among [candidate_tokens], such that it may be placed after [prev_token]
+// Throws, if there is none
+token_t prune_tokens(
+    token_t& prev_token,
+    util::vector<token_t>& candidate_tokens
+);
+
 } // namespace detail
 
+// Options of compilation, performed by postfix_converter_t::convert
+struct compile_options_t {
+    compile_options_t():
+        constant_folding(true),
+        common_subexpressions(true),
+        strength_reduction(true),
+        relaxed_precision(false),
+        polynomials(true),
+        reassociation(true),
+        scheduling(true),
+        parallel_task_size(parallel::subtree_program_t::default_min_task_size),
+        superinstructions( bytecode::superinstruction_set_t::all() )
+    {}
+
+    // collapse operators on numbers into numbers (disable for debugging)
+    bool constant_folding;
+
+    // evaluate structurally identical subexpressions once (see optimizer::expr_dag_t)
+    bool common_subexpressions;
+
+    // replace powers and divisions by constants with cheaper operators (see optimizer::reduce_strength)
+    bool strength_reduction;
+
+    // allow rewrites, which may change result in last bits (e.g. x / 3 -> x * 0.333...)
+    // Rewrites of polynomials may also change results of infinite and NaN inputs
+    bool relaxed_precision;
+
+    // rewrite polynomials in Horner form on fma (see optimizer::rewrite_polynomials)
+    // Changes rounding and removes cancelled terms (x*x - x*x + x -> x, so that inf gives inf, not NaN),
+    // so it is performed only with relaxed_precision
+    bool polynomials;
+
+    // evaluate chains of + and * as balanced trees (see optimizer::reassociate)
+    // Changes rounding within documented bound, so it is performed only with relaxed_precision
+    bool reassociation;
+
+    // evaluate operand, needing more stack, first (see optimizer::schedule_operands)
+    bool scheduling;
+
+    // instructions of the smallest subtree, evaluated as separate task by evaluate_parallel
+    // (see parallel::subtree_program_t); 0 - expressions are always evaluated serially
+    int parallel_task_size;
+
+    // superinstructions fused into program, e.g. derived by bytecode::ngram_profiler_t
+    bytecode::superinstruction_set_t superinstructions;
+};
+
+// Evaluation backends of postfix_expr_t
+enum class backend_t {
+    switch_dispatch,    /*switch-based bytecode interpreter*/
+    threaded,           /*direct-threaded bytecode interpreter (computed goto)*/
+    register_vm,        /*three-address register interpreter*/
+    jit,                /*native x86-64 code, other platforms use switch_dispatch*/
+    slp                 /*independent operators packed into SIMD lanes (SSE2/AVX2), scalar lanes elsewhere*/
+};
+
 class postfix_expr_t {
 public:
-    postfix_expr_t() {}
+    postfix_expr_t():
+        num_variables(0),
+        backend(backend_t::switch_dispatch),
+        parallel_task_size(0),
+        is_split(false) {}
 
+    // select backend used by evaluate()
+    // Backend-specific form of program is prepared here, not during evaluation
+    void set_backend(backend_t new_backend);
+
+    backend_t get_backend() const {
+        return backend;
+    }
+
+    // evaluates compiled bytecode program
+    // Uses scratch buffer allocated by convert, thus does not allocate
+    // Throws, if expression has variables
     double evaluate();
+
+    // evaluates compiled bytecode program, where variable of slot i is values[i]
+    // [values] must hold get_num_variables() values
+    double evaluate_at(const double *values);
+
+    // evaluates compiled bytecode program, using caller-supplied buffer
+    // [scratch] must hold at least get_scratch_size() values,
+    // variables are taken from scratch[get_variables_offset() + slot]
+    double evaluate(double *scratch) const;
+
+    // evaluates compiled program over [num_rows] rows: results[row] is value,
+    // where variable of slot v is columns[v][row] (structure of arrays)
+    // Uses vector kernels of running CPU (see simd::batch_program_t), regardless of backend
+    // Batch form of program and its blocks are built by the first call, later calls do not allocate
+    void evaluate_batch(const double *const *columns, int num_rows, double *results);
+
+    // evaluates compiled program over [num_rows] rows, variable of slot v being read
+    // through bindings[v], e.g. from field of array of structs, without copying it
+    void evaluate_batch(const simd::binding_t *bindings, int num_rows, double *results);
+
+    // evaluates compiled program, large independent subtrees being evaluated in parallel on [pool]
+    // Expressions, smaller than compile_options_t::parallel_task_size allows to split, are evaluated serially
+    // Program is split by the first call, later calls do not allocate
+    // Variable of slot v is values[v]; [values] may be NULL, if expression has no variables
+    // Result is identical to that of evaluate()
+    double evaluate_parallel(parallel::thread_pool_t& pool, const double *values = NULL);
+
+    // evaluates expression token by token (reference implementation)
+    // Throws, if expression has variables
+    double evaluate_tokens();
+
+    // number of variables, declared by converter at conversion
+    int get_num_variables() const {
+        return num_variables;
+    }
+
+    // position of variables in scratch of evaluate(double *scratch)
+    int get_variables_offset() const {
+        return program.get_variables_offset();
+    }
+
+    // number of values required by evaluate(double *scratch)
+    // Depends on backend: slp keeps every value in its own slot
+    int get_scratch_size() const {
+        return std::max(program.get_scratch_size(), packed.get_num_slots());
+    }
+
+    const bytecode::program_t& get_program() const {
+        return program;
+    }
+
+    // rewrites, performed by optimization passes during compilation
+    const util::vector<optimizer::rewrite_t>& get_rewrites() const {
+        return rewrites;
+    }
+
 private:
 
     util::vector< token_t > expr;
+    bytecode::program_t program;
+    util::vector<optimizer::rewrite_t> rewrites;
+    int num_variables;
+
+    backend_t backend;
+    bytecode::threaded_program_t threaded;
+    bytecode::register_program_t registers;
+    jit::jit_program_t native;
+    simd::slp_program_t packed;
+    simd::batch_program_t batch; /*independent of backend, built on demand*/
+    parallel::subtree_program_t subtrees; /*independent of backend, built on demand*/
+    int parallel_task_size; /*of compile_options_t, used to build subtrees*/
+    bool is_split; /*subtrees are built, though program may be left whole*/
+
+    // build backend-specific form of program and scratch buffer for it
+    void prepare_backend();
+
+    // build batch form of program and blocks for it, if they are not built yet
+    void prepare_batch();
+
+    // split program into subtrees, if it is not split yet
+    void prepare_subtrees();
+
+    // preallocated value stacks, reused by evaluations
+    util::vector<double> eval_st;
+    util::stack<double> token_st;
+    util::vector<double> batch_st;
+
+    // lower expr into program
+    void compile(const compile_options_t& options);
 
     friend class postfix_converter_t; 
 };
@@ -113,15 +324,74 @@ public:
         builder::multiplication(),
         builder::division(),
         /*functions*/
-        builder::exp()
+        builder::exp(),
+        builder::fma()
     }) { }
 
+    // characters of the smallest chunk, converted as separate task by convert_parallel
+    static const int default_parallel_chunk_size = 1 << 16;
+
     postfix_expr_t
-    convert(const std::string& input);
+    convert(std::string_view input);
+
+    // converts input [beg, end), e.g. line of memory-mapped file, without copying it
+    // Input need not be null-terminated
+    postfix_expr_t
+    convert(const char *beg, const char *end);
+
+    // converts [input] on [pool], result is identical to that of convert(input)
+    // Input is split at top-level + and - (outside of any parentheses) into chunks
+    // of at least [min_chunk_size] characters, which are converted concurrently by copies of converter.
+    // Postfix of a + b is postfix of a, postfix of b and operator, thus their postfix is stitched together.
+    // Inputs, which can not be split this way (smaller ones, top-level commas, unbalanced parentheses),
+    // and invalid ones are converted serially, so that error is the same as well.
+    // Pool of single worker converts serially too
+    postfix_expr_t
+    convert_parallel(
+        std::string_view input,
+        parallel::thread_pool_t& pool,
+        int min_chunk_size = default_parallel_chunk_size
+    );
+
+    // Converter with the same options and variables, which shares no tokens with this one,
+    // so that both may be used by different threads
+    postfix_converter_t clone() const;
+
+    // Declare variable [name], which may be used by converted expressions
+    // Returns its slot: index of its value in evaluate_at and evaluate_batch
+    // Throws, if name is not identifier, is name of function or is already declared
+    std::uint32_t add_variable(const std::string& name) {
+        return impl.add_variable(name);
+    }
+
+    // names of variables, indexed by slot
+    const util::vector<std::string>& get_variables() const {
+        return impl.get_variables();
+    }
+
+    void set_options(const compile_options_t& new_options) {
+        options = new_options;
+    }
+
+    const compile_options_t& get_options() const {
+        return options;
+    }
 
 private:
     detail::postfix_converter_impl_t impl;
+    compile_options_t options;
+
+    // converts input [beg, end) token by token into postfix [expr], without compiling it
+    // If [mark] is given, [mark_size] is set to size of expr, once token at [mark] is converted
+    void convert_tokens(
+        const char *beg,
+        const char *end,
+        util::vector<token_t>& expr /*out*/,
+        const char *mark = NULL,
+        int *mark_size = NULL /*out*/
+    );
 
+    friend class stream_converter_t;
 };
 
 } // namespace postfix
@@ -0,0 +1,162 @@
+#include "reassociation.h"
+
+#include <algorithm>
+#include <string>
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+// Chains of sum class are flattened together, as are chains of product class
+enum class chain_t { none, sum, product };
+
+chain_t chain_of(op_t op) {
+    switch(op) {
+    case op_t::add:
+    case op_t::sub:
+        return chain_t::sum;
+    case op_t::mul:
+        return chain_t::product;
+    default:
+        return chain_t::none;
+    }
+}
+
+int ceil_log2(int n) {
+    int res = 0;
+    while((1 << res) < n)
+        ++res;
+    return res;
+}
+
+// Balanced tree of [op] over [terms]: adjacent pairs are combined level by level,
+// so that tree of n terms has ceil(log2 n) levels
+int balanced(expr_dag_t& out, op_t op, util::vector<int> terms) {
+    while(terms.size() > 1) {
+        util::vector<int> next;
+        for(int i = 0; i < terms.size(); i += 2) {
+            if(i + 1 < terms.size())
+                next.push_back(out.make_binary(op, terms[i], terms[i + 1]));
+            else
+                next.push_back(terms[i]);
+        }
+
+        terms = next;
+    }
+
+    return terms[0];
+}
+
+} // namespace
+
+
+expr_dag_t reassociate(const expr_dag_t& dag, util::vector<rewrite_t> *rewrites) {
+    expr_dag_t res(dag.hash_consing());
+    if(dag.get_root() < 0)
+        return res;
+
+    // Node is inner part of chain, if its only user is operator of the same chain.
+    // Node, used twice by the same parent (e.g. (a + b) * (a + b)), stays term
+    util::vector<int> uses = dag.count_uses();
+    util::vector<bool> inner(dag.size(), false);
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+        chain_t chain = chain_of(node.op);
+        if(uses[i] == 0 || chain == chain_t::none || node.children[0] == node.children[1])
+            continue;
+
+        for(int j = 0; j < node.num_children; ++j) {
+            int child = node.children[j];
+            if(uses[child] == 1 && chain_of(dag.get_node(child).op) == chain)
+                inner[child] = true;
+        }
+    }
+
+    // critical path of chain, as it is written
+    util::vector<int> chain_depth(dag.size(), 0);
+    util::vector<int> node_map(dag.size(), -1);
+
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+
+        if(node.op == op_t::push_const) {
+            node_map[i] = res.make_const(node.value);
+            continue;
+        }
+        if(node.op == op_t::load_var) {
+            node_map[i] = res.make_var((std::uint32_t) node.value);
+            continue;
+        }
+
+        chain_t chain = chain_of(node.op);
+        if(chain != chain_t::none) {
+            for(int j = 0; j < node.num_children; ++j)
+                if(inner[node.children[j]])
+                    chain_depth[i] = std::max(chain_depth[i], chain_depth[node.children[j]]);
+            ++chain_depth[i];
+        }
+
+        // terms of chain in source order, with their signs
+        // Leftmost term is never subtracted, so there is always positive one
+        util::vector<int> positive, negative;
+        if(chain != chain_t::none && !inner[i]) {
+            util::vector<int> pending;
+            util::vector<bool> pending_negated;
+            pending.push_back(i);
+            pending_negated.push_back(false);
+
+            while(!pending.empty()) {
+                int idx = pending[pending.size() - 1];
+                bool negated = pending_negated[pending_negated.size() - 1];
+                pending.pop_back();
+                pending_negated.pop_back();
+
+                if(idx != i && !inner[idx]) {
+                    (negated ? negative : positive).push_back(node_map[idx]);
+                    continue;
+                }
+
+                // children are pushed in reverse, so that they are popped in order
+                const dag_node_t& cur = dag.get_node(idx);
+                for(int j = cur.num_children - 1; j >= 0; --j) {
+                    pending.push_back(cur.children[j]);
+                    pending_negated.push_back(negated != (cur.op == op_t::sub && j == 1));
+                }
+            }
+        }
+
+        int num_terms = positive.size() + negative.size();
+        int new_depth = ceil_log2(std::max(positive.size(), negative.size())) + !negative.empty();
+
+        // inner nodes are mapped as they are: chain may be left as it is
+        if(num_terms < 3 || new_depth >= chain_depth[i]) {
+            int children[max_node_children];
+            for(int j = 0; j < node.num_children; ++j)
+                children[j] = node_map[node.children[j]];
+            node_map[i] = res.make_node(node.op, node.num_children, children);
+            continue;
+        }
+
+        op_t op = chain == chain_t::sum ? op_t::add : op_t::mul;
+        node_map[i] = balanced(res, op, positive);
+        if(!negative.empty())
+            node_map[i] = res.make_binary(op_t::sub, node_map[i], balanced(res, op, negative));
+
+        if(rewrites) {
+            rewrite_t rewrite = {
+                chain == chain_t::sum ? "sum_to_balanced" : "product_to_balanced",
+                std::string(chain == chain_t::sum ? "sum of " : "product of ") +
+                std::to_string(num_terms) + " terms (depth " + std::to_string(chain_depth[i]) +
+                ") -> balanced tree (depth " + std::to_string(new_depth) + ")"
+            };
+            rewrites->push_back(rewrite);
+        }
+    }
+
+    res.set_root(node_map[dag.get_root()]);
+    return res;
+}
+
+} // namespace postfix::optimizer
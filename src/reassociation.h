@@ -0,0 +1,36 @@
+#ifndef REASSOCIATION_H
+#define REASSOCIATION_H
+
+/**
+ * Reassociation over expression DAG
+ *      Chains of + and - (sums) and of * (products) are flattened into n-ary nodes
+ *      and evaluated as balanced trees
+*/
+
+#include "expr_dag.h"
+
+#include "util/vector.h"
+
+namespace postfix::optimizer {
+
+// Returns [dag], where sums a + b - c + ... and products a * b * c * ...
+// are evaluated as balanced trees: (a + b) + (c + d) instead of ((a + b) + c) + d.
+// Critical path of n terms shrinks from n - 1 to ceil(log2 n) (+1 for subtracted terms),
+// so that independent operators overlap in CPU pipeline (and in SIMD lanes of backend_t::slp).
+// Subtracted terms are summed separately: sum(positive) - sum(subtracted).
+// Nodes, used more than once, are kept as terms, so that they are still evaluated once.
+// Chain is rewritten, only if its critical path becomes shorter.
+//
+// Rounding changes, so pass is meant for relaxed precision. With u = 2^-53,
+// g(k) = k * u / (1 - k * u) and no overflow or underflow in either order:
+//      sum of n terms x_i differs from left-to-right sum at most by
+//          (g(n - 1) + g(ceil(log2 n) + 1)) * sum |x_i|
+//      product of n factors differs from left-to-right product at most by
+//          2 * g(n - 1) * |product|
+// Intermediate overflow may differ, e.g. 1e308 + 1e308 - 1e308 + ... may become finite.
+// Every rewrite is appended to [rewrites], if it is not NULL
+expr_dag_t reassociate(const expr_dag_t& dag, util::vector<rewrite_t> *rewrites /*out*/);
+
+} // namespace postfix::optimizer
+
+#endif
@@ -0,0 +1,222 @@
+#include "register_vm.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace postfix::bytecode {
+
+// Operator, which is performed by superinstruction with immediate or by reversed operator
+static opcode_t basic_op(opcode_t op) {
+    switch(op) {
+    case opcode_t::rsub:
+        return opcode_t::sub;
+    case opcode_t::rdiv:
+        return opcode_t::div;
+    case opcode_t::rpow:
+        return opcode_t::pow;
+    case opcode_t::add_imm:
+        return opcode_t::add;
+    case opcode_t::sub_imm:
+        return opcode_t::sub;
+    case opcode_t::mul_imm:
+        return opcode_t::mul;
+    case opcode_t::div_imm:
+        return opcode_t::div;
+    case opcode_t::pow_imm:
+        return opcode_t::pow;
+    default:
+        return op;
+    }
+}
+
+register_program_t::register_program_t(const program_t& prog):
+    constants(prog.get_constants()),
+    num_registers(0),
+    result(0),
+    is_lowered(false)
+{
+    if(!prog.valid() || prog.get_scratch_size() > max_registers)
+        return;
+
+    // temporaries are kept in registers following stack registers
+    const int temp_base = prog.get_max_depth();
+    num_registers = prog.get_num_temps() > 0 || prog.get_num_variables() > 0 ? prog.get_scratch_size() : 0;
+
+    // Operands, which would reside on value stack of stack machine
+    // Value at stack position i is kept in register i
+    util::vector<operand_t> st;
+    const util::vector<instruction_t>& src = prog.get_code();
+
+    for(int i = 0; i < src.size(); ++i) {
+        const instruction_t& instr = src[i];
+        reg_instruction_t reg_instr = { instr.op, 0, 0, 0, 0 };
+
+        switch(instr.op) {
+        case opcode_t::push_const:
+            // constant is not moved into register, it is used in place
+            st.push_back(make_const_operand(instr.arg));
+            continue;
+        case opcode_t::neg:
+        case opcode_t::sqrt:
+            reg_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            break;
+        case opcode_t::add:
+        case opcode_t::sub:
+        case opcode_t::mul:
+        case opcode_t::div:
+        case opcode_t::pow:
+            reg_instr.rhs = st[st.size() - 1];
+            st.pop_back();
+            reg_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            break;
+        case opcode_t::rsub:
+        case opcode_t::rdiv:
+        case opcode_t::rpow:
+            // operands are named in place, so reversed operator is basic one
+            reg_instr.op = basic_op(instr.op);
+            reg_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            reg_instr.rhs = st[st.size() - 1];
+            st.pop_back();
+            break;
+        case opcode_t::fma:
+            reg_instr.addend = st[st.size() - 1];
+            st.pop_back();
+            reg_instr.rhs = st[st.size() - 1];
+            st.pop_back();
+            reg_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            break;
+        case opcode_t::add_imm:
+        case opcode_t::sub_imm:
+        case opcode_t::mul_imm:
+        case opcode_t::div_imm:
+        case opcode_t::pow_imm:
+            // immediate becomes constant operand of basic operator
+            reg_instr.op = basic_op(instr.op);
+            reg_instr.rhs = make_const_operand(instr.arg);
+            reg_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            break;
+        case opcode_t::mul_imm_add:
+        case opcode_t::mul_imm_sub: {
+            // split into y * imm and x +- (y * imm)
+            reg_instruction_t mul_instr = { opcode_t::mul, 0, 0, make_const_operand(instr.arg), 0 };
+            mul_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            mul_instr.dst = (std::uint8_t) st.size();
+            num_registers = std::max(num_registers, (int) st.size() + 1);
+            code.push_back(mul_instr);
+
+            reg_instr.op = instr.op == opcode_t::mul_imm_add ? opcode_t::add : opcode_t::sub;
+            reg_instr.rhs = make_reg_operand(mul_instr.dst);
+            reg_instr.lhs = st[st.size() - 1];
+            st.pop_back();
+            break;
+        }
+        case opcode_t::dup: {
+            // copy refers to the same operand (pushed by value, push_back may reallocate)
+            operand_t top = st[st.size() - 1];
+            st.push_back(top);
+            continue;
+        }
+        case opcode_t::store_tmp: {
+            std::uint8_t tmp_reg = (std::uint8_t) (temp_base + instr.arg);
+            operand_t& top = st[st.size() - 1];
+
+            // value was just computed into register of its stack position,
+            // so compute it right into temporary
+            if(
+                !code.empty() &&
+                code[code.size() - 1].dst == st.size() - 1 &&
+                top == make_reg_operand(code[code.size() - 1].dst)
+            ) {
+                code[code.size() - 1].dst = tmp_reg;
+            } else {
+                reg_instruction_t mov = { opcode_t::store_tmp, tmp_reg, top, 0, 0 };
+                code.push_back(mov);
+            }
+
+            top = make_reg_operand(tmp_reg);
+            continue;
+        }
+        case opcode_t::load_tmp:
+            st.push_back(make_reg_operand(temp_base + instr.arg));
+            continue;
+        case opcode_t::load_var: /*variables follow temporaries*/
+            st.push_back(make_reg_operand(prog.get_variables_offset() + instr.arg));
+            continue;
+        case opcode_t::nop:
+        case opcode_t::halt:
+            continue;
+        }
+
+        // result takes place of first operand
+        reg_instr.dst = (std::uint8_t) st.size();
+        num_registers = std::max(num_registers, (int) st.size() + 1);
+
+        code.push_back(reg_instr);
+        st.push_back(make_reg_operand(reg_instr.dst));
+    }
+
+    assert(st.size() == 1);
+    result = st[0];
+    is_lowered = true;
+}
+
+double register_program_t::run(double *regs) const {
+    assert(lowered());
+
+    // operand's flag bit selects base array
+    const double *bases[2] = { regs, constants.begin() };
+
+#define VALUE(operand) bases[(operand) >> 31][(operand) & ~operand_const_flag]
+
+    const reg_instruction_t
+        *ip = code.begin(),
+        *end = code.end();
+
+    for(; ip != end; ++ip) {
+        switch(ip->op) {
+        case opcode_t::add:
+            regs[ip->dst] = VALUE(ip->lhs) + VALUE(ip->rhs);
+            break;
+        case opcode_t::sub:
+            regs[ip->dst] = VALUE(ip->lhs) - VALUE(ip->rhs);
+            break;
+        case opcode_t::neg:
+            regs[ip->dst] = -VALUE(ip->lhs);
+            break;
+        case opcode_t::mul:
+            regs[ip->dst] = VALUE(ip->lhs) * VALUE(ip->rhs);
+            break;
+        case opcode_t::div:
+            regs[ip->dst] = VALUE(ip->lhs) / VALUE(ip->rhs);
+            break;
+        case opcode_t::pow:
+            regs[ip->dst] = std::pow(VALUE(ip->lhs), VALUE(ip->rhs));
+            break;
+        case opcode_t::sqrt:
+            regs[ip->dst] = pow_half(VALUE(ip->lhs));
+            break;
+        case opcode_t::fma:
+            regs[ip->dst] = std::fma(VALUE(ip->lhs), VALUE(ip->rhs), VALUE(ip->addend));
+            break;
+        case opcode_t::store_tmp: /*register move*/
+            regs[ip->dst] = VALUE(ip->lhs);
+            break;
+        default: /*other opcodes are not emitted into register program*/
+            break;
+        }
+    }
+
+    double res = VALUE(result);
+#undef VALUE
+
+    return res;
+}
+
+} // namespace postfix::bytecode
@@ -0,0 +1,85 @@
+#ifndef REGISTER_VM_H
+#define REGISTER_VM_H
+
+/**
+ * Register form of bytecode program
+ *      Three-address instructions: dst = lhs op rhs
+ *      Lowering from stack program
+ *      Interpreter
+*/
+
+#include <cstdint>
+
+#include "bytecode.h"
+
+#include "util/vector.h"
+
+namespace postfix::bytecode {
+
+// Operand of register instruction
+// Refers either to register or to constant of source program
+typedef std::uint32_t operand_t;
+
+const operand_t operand_const_flag = 0x80000000u;
+
+inline operand_t make_reg_operand(std::uint32_t reg) {
+    return reg;
+}
+
+inline operand_t make_const_operand(std::uint32_t const_idx) {
+    return const_idx | operand_const_flag;
+}
+
+inline bool is_const_operand(operand_t operand) {
+    return (operand & operand_const_flag) != 0;
+}
+
+struct reg_instruction_t {
+    opcode_t op;
+    std::uint8_t dst;   /*register*/
+    operand_t lhs;
+    operand_t rhs;      /*unused by unary operators*/
+    operand_t addend;   /*used only by fma*/
+};
+
+// Three-address form of program_t
+// Stack slots are mapped onto registers of fixed file, constants are used in place.
+// Programs, which need more registers than the file provides, are not lowered
+class register_program_t {
+public:
+    // size of register file
+    static const int max_registers = 256;
+
+    register_program_t(): num_registers(0), result(0), is_lowered(false) {}
+
+    explicit register_program_t(const program_t& prog);
+
+    // false, if program could not be lowered (e.g. it is invalid or too deep)
+    bool lowered() const {
+        return is_lowered;
+    }
+
+    // number of registers used by program
+    int get_num_registers() const {
+        return num_registers;
+    }
+
+    const util::vector<reg_instruction_t>& get_code() const {
+        return code;
+    }
+
+    // [regs] must hold at least get_num_registers() values
+    double run(double *regs) const;
+
+private:
+    util::vector<reg_instruction_t> code;
+    util::vector<double> constants;
+
+    int num_registers;
+    operand_t result; /*operand holding value of expression*/
+    bool is_lowered;
+};
+
+} // namespace postfix::bytecode
+
+#endif
@@ -0,0 +1,67 @@
+#include "scheduling.h"
+
+#include <algorithm>
+
+namespace postfix::optimizer {
+
+typedef bytecode::opcode_t op_t;
+
+op_t reversed_operator(op_t op) {
+    switch(op) {
+    case op_t::add:
+    case op_t::mul:
+        return op;
+    case op_t::sub:
+        return op_t::rsub;
+    case op_t::div:
+        return op_t::rdiv;
+    case op_t::pow:
+        return op_t::rpow;
+    default:
+        return op_t::nop;
+    }
+}
+
+util::vector<int> sethi_ullman_numbers(const expr_dag_t& dag) {
+    util::vector<int> need(dag.size(), 1);
+
+    // children precede parents
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+        if(node.num_children == 0)
+            continue;
+
+        if(node.num_children == 2 && reversed_operator(node.op) != op_t::nop) {
+            int lhs = need[node.children[0]];
+            int rhs = need[node.children[1]];
+            need[i] = lhs == rhs ? lhs + 1 : std::max(lhs, rhs);
+            continue;
+        }
+
+        // operands in given order: j-th operand is evaluated above j values
+        int res = 1;
+        for(int j = 0; j < node.num_children; ++j)
+            res = std::max(res, need[node.children[j]] + j);
+        need[i] = res;
+    }
+
+    return need;
+}
+
+util::vector<bool> schedule_operands(const expr_dag_t& dag) {
+    util::vector<int> need = sethi_ullman_numbers(dag);
+    util::vector<bool> reversed(dag.size(), false);
+
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+        if(node.num_children != 2 || reversed_operator(node.op) == op_t::nop)
+            continue;
+
+        // on ties source order is kept
+        reversed[i] = need[node.children[1]] > need[node.children[0]];
+    }
+
+    return reversed;
+}
+
+} // namespace postfix::optimizer
@@ -0,0 +1,31 @@
+#ifndef SCHEDULING_H
+#define SCHEDULING_H
+
+/**
+ * Operand scheduling over expression DAG
+ *      Sethi-Ullman numbering
+ *      Order of operands, which minimizes value stack depth
+*/
+
+#include "expr_dag.h"
+
+#include "util/vector.h"
+
+namespace postfix::optimizer {
+
+// Number of stack slots, needed to evaluate every node of [dag] as tree
+// (shared nodes are counted, as if they were evaluated in place)
+util::vector<int> sethi_ullman_numbers(const expr_dag_t& dag);
+
+// For every node of [dag]: true, if its second operand must be evaluated first,
+// as it needs more stack slots than the first one.
+// Only operators with reversed form (see bytecode::opcode_t::rsub) are reordered
+util::vector<bool> schedule_operands(const expr_dag_t& dag);
+
+// Operator, which takes operands of [op] in reverse order, or [op] itself, if it is commutative
+// Returns nop, if [op] has no reversed form
+bytecode::opcode_t reversed_operator(bytecode::opcode_t op);
+
+} // namespace postfix::optimizer
+
+#endif
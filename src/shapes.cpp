@@ -0,0 +1,92 @@
+#include "shapes.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace postfix::simd {
+
+bool shape_set_t::shape_key_t::operator==(const shape_key_t& other) const {
+    if(code.size() != other.code.size())
+        return false;
+
+    for(int i = 0; i < code.size(); ++i) {
+        if(code[i].op != other.code[i].op || code[i].arg != other.code[i].arg)
+            return false;
+    }
+
+    return true;
+}
+
+std::size_t shape_set_t::shape_key_hash_t::operator()(const shape_key_t& key) const {
+    // FNV-1a over opcodes and arguments
+    std::size_t res = 14695981039346656037ull;
+    for(int i = 0; i < key.code.size(); ++i) {
+        res = (res ^ (std::size_t) key.code[i].op) * 1099511628211ull;
+        res = (res ^ key.code[i].arg) * 1099511628211ull;
+    }
+
+    return res;
+}
+
+int shape_set_t::add(const bytecode::program_t& prog) {
+    prog.check();
+
+    shape_key_t key = { prog.get_code() };
+    std::unordered_map<shape_key_t, int, shape_key_hash_t>::iterator it = shape_index.find(key);
+    if(it == shape_index.end()) {
+        shape_t shape;
+        shape.program = batch_program_t(prog, isa);
+        shapes.push_back(shape);
+        it = shape_index.insert(std::make_pair(key, shapes.size() - 1)).first;
+    }
+
+    shape_t& shape = shapes[it->second];
+    const util::vector<double>& values = prog.get_constants();
+    const int block_rows = batch_program_t::block_rows;
+
+    // Constants are laid out block by block: block_rows values of constant 0, then of constant 1...
+    // Rows past the last program of shape are computed too, their constants are 0
+    int row = shape.members.size();
+    if(row % block_rows == 0) {
+        for(int i = 0; i < values.size() * block_rows; ++i)
+            shape.constants.push_back(0);
+    }
+
+    double *block = shape.constants.begin() + row / block_rows * values.size() * block_rows;
+    for(int c = 0; c < values.size(); ++c)
+        block[c * block_rows + row % block_rows] = values[c];
+
+    shape.members.push_back(num_exprs);
+    num_vars = std::max(num_vars, prog.get_num_variables());
+
+    return num_exprs++;
+}
+
+void shape_set_t::evaluate_all(double *results, const double *values) {
+    if(num_vars > 0 && values == NULL)
+        throw std::logic_error("shape_set_t: programs have variables, their values are required");
+
+    // every row of shape reads the same value of variable
+    bindings.clear();
+    for(int v = 0; v < num_vars; ++v) {
+        binding_t binding = { values + v, 0, 0 };
+        bindings.push_back(binding);
+    }
+
+    for(int s = 0; s < shapes.size(); ++s) {
+        const shape_t& shape = shapes[s];
+        int num_rows = shape.members.size();
+
+        if(scratch.size() < shape.program.get_scratch_size())
+            scratch = util::vector<double>(shape.program.get_scratch_size());
+        if(rows.size() < num_rows)
+            rows = util::vector<double>(num_rows);
+
+        shape.program.run(shape.constants.begin(), bindings.begin(), num_rows, rows.begin(), scratch.begin());
+
+        for(int r = 0; r < num_rows; ++r)
+            results[shape.members[r]] = rows[r];
+    }
+}
+
+} // namespace postfix::simd
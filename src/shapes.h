@@ -0,0 +1,81 @@
+#ifndef SHAPES_H
+#define SHAPES_H
+
+/**
+ * Evaluation of many expressions of the same shape at once
+ *      Shape: compiled program with values of its constants abstracted away
+ *      Programs are bucketed by hash of shape, every bucket is evaluated
+ *      by batch kernel, expressions of bucket being its rows
+*/
+
+#include <cstddef>
+#include <unordered_map>
+
+#include "batch.h"
+#include "bytecode.h"
+
+#include "util/vector.h"
+
+namespace postfix::simd {
+
+// Set of expressions, evaluated together
+// Expressions, which differ only in numeric constants (e.g. a * x + b with different a and b),
+// share program: it is executed once per block of expressions, constants being vectors
+// with lane per expression, so that throughput scales with vector width
+class shape_set_t {
+public:
+    // [isa] selects kernel; it must be supported by running CPU
+    explicit shape_set_t(isa_t new_isa = native_isa()): num_exprs(0), num_vars(0), isa(new_isa) {}
+
+    // Adds program, returns index of its value in results of evaluate_all
+    // Throws, if program is invalid (see bytecode::program_t::check)
+    int add(const bytecode::program_t& prog);
+
+    // number of added programs
+    int size() const {
+        return num_exprs;
+    }
+
+    // number of distinct shapes among added programs
+    int get_num_shapes() const {
+        return shapes.size();
+    }
+
+    // results[i] = value of i-th added program, where variable of slot v is values[v]
+    // [values] may be NULL, if programs have no variables, otherwise throws
+    void evaluate_all(double *results, const double *values = NULL);
+
+private:
+    // Shape of program: its code; constants are referred to by index
+    struct shape_key_t {
+        util::vector<bytecode::instruction_t> code;
+
+        bool operator==(const shape_key_t& other) const;
+    };
+
+    struct shape_key_hash_t {
+        std::size_t operator()(const shape_key_t& key) const;
+    };
+
+    struct shape_t {
+        batch_program_t program;        /*of first program of shape*/
+        util::vector<double> constants; /*constants of rows, see batch_program_t::run*/
+        util::vector<int> members;      /*indices of programs, in order of rows*/
+    };
+
+    util::vector<shape_t> shapes;
+    std::unordered_map<shape_key_t, int, shape_key_hash_t> shape_index;
+
+    int num_exprs;
+    int num_vars; /*max over programs*/
+    isa_t isa;
+
+    // buffers of evaluate_all
+    util::vector<double> scratch;
+    util::vector<double> rows;
+    util::vector<binding_t> bindings;
+};
+
+} // namespace postfix::simd
+
+#endif
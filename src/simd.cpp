@@ -0,0 +1,49 @@
+#include "simd.h"
+
+namespace postfix::simd {
+
+static isa_t detect_isa() {
+#if POSTFIX_HAS_SIMD
+    // __builtin_cpu_supports reads CPUID and checks, that OS enabled state of wide registers
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return isa_t::avx512;
+    if(__builtin_cpu_supports("avx2"))
+        return isa_t::avx2;
+    return isa_t::sse2; /*baseline of x86-64*/
+#else
+    return isa_t::scalar;
+#endif
+}
+
+isa_t native_isa() {
+    static const isa_t isa = detect_isa();
+    return isa;
+}
+
+bool isa_supported(isa_t isa) {
+    return isa <= native_isa();
+}
+
+int isa_lanes(isa_t isa) {
+    switch(isa) {
+    case isa_t::avx512:
+        return 8;
+    case isa_t::avx2:
+        return 4;
+    case isa_t::sse2:
+        return 2;
+    case isa_t::scalar:
+        break;
+    }
+
+    return 1;
+}
+
+const char *isa_name(isa_t isa) {
+    // indexed by isa_t
+    static const char *names[] = { "scalar", "sse2", "avx2", "avx512" };
+    return names[(int) isa];
+}
+
+} // namespace postfix::simd
@@ -0,0 +1,43 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/**
+ * Instruction sets of vector evaluators
+ *      Detection of running CPU (CPUID)
+*/
+
+// SSE2/AVX2/AVX-512 evaluators are available on x86-64 with GCC or Clang
+#ifndef POSTFIX_HAS_SIMD
+#if defined(__x86_64__) && defined(__GNUC__)
+#define POSTFIX_HAS_SIMD 1
+#else
+#define POSTFIX_HAS_SIMD 0
+#endif
+#endif
+
+namespace postfix::simd {
+
+// Instruction sets of vector evaluators, from narrowest to widest
+enum class isa_t {
+    scalar,     /*lanes are computed one by one*/
+    sse2,       /*2 lanes of double*/
+    avx2,       /*4 lanes of double*/
+    avx512      /*8 lanes of double (AVX-512F)*/
+};
+
+// Widest instruction set, supported by running CPU (and by OS, which must save wide registers)
+// CPUID is queried once
+isa_t native_isa();
+
+// true, if [isa] can be used on running CPU
+bool isa_supported(isa_t isa);
+
+// Number of lanes of double in vector register of [isa]
+int isa_lanes(isa_t isa);
+
+// name of [isa], e.g. for benchmark reports
+const char *isa_name(isa_t isa);
+
+} // namespace postfix::simd
+
+#endif
@@ -0,0 +1,324 @@
+#include "slp.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if POSTFIX_HAS_SIMD
+#include <immintrin.h>
+#endif
+
+namespace postfix::simd {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+typedef bytecode::operand_t operand_t;
+
+// operand's flag bit selects base array: slots or constants
+#define VALUE(operand) bases[(operand) >> 31][(operand) & ~bytecode::operand_const_flag]
+
+// Operators, which are computed by vector instructions exactly as by scalar ones
+bool vectorizable(op_t op) {
+    switch(op) {
+    case op_t::add:
+    case op_t::sub:
+    case op_t::mul:
+    case op_t::div:
+    case op_t::neg:
+        return true;
+    default:
+        return false;
+    }
+}
+
+double apply(op_t op, double x, double y, double z) {
+    switch(op) {
+    case op_t::add: return x + y;
+    case op_t::sub: return x - y;
+    case op_t::mul: return x * y;
+    case op_t::div: return x / y;
+    case op_t::neg: return -x;
+    case op_t::pow: return std::pow(x, y);
+    case op_t::sqrt: return bytecode::pow_half(x);
+    case op_t::fma: return std::fma(x, y, z);
+    default:
+        assert(false);
+        return 0;
+    }
+}
+
+// Computes lanes of [instr] one by one
+void run_lanes(const slp_instruction_t& instr, double *slots, const double *const *bases) {
+    double args[optimizer::max_node_children] = { 0, 0, 0 };
+
+    for(int k = 0; k < instr.width; ++k) {
+        for(int j = 0; j < instr.num_operands; ++j)
+            args[j] = VALUE(instr.args[j][k]);
+        slots[instr.dst + k] = apply(instr.op, args[0], args[1], args[2]);
+    }
+}
+
+#if POSTFIX_HAS_SIMD
+
+__m128d load_sse2(const slp_instruction_t& instr, int j, const double *const *bases) {
+    const operand_t *args = instr.args[j];
+
+    switch(instr.load[j]) {
+    case lane_load_t::contiguous:
+        return _mm_loadu_pd(&VALUE(args[0]));
+    case lane_load_t::broadcast:
+        return _mm_set1_pd(VALUE(args[0]));
+    default:
+        return _mm_set_pd(VALUE(args[1]), VALUE(args[0]));
+    }
+}
+
+void exec_sse2(const slp_instruction_t& instr, double *slots, const double *const *bases) {
+    if(instr.width != 2 || !vectorizable(instr.op)) {
+        run_lanes(instr, slots, bases);
+        return;
+    }
+
+    __m128d x = load_sse2(instr, 0, bases), res;
+    switch(instr.op) {
+    case op_t::add: res = _mm_add_pd(x, load_sse2(instr, 1, bases)); break;
+    case op_t::sub: res = _mm_sub_pd(x, load_sse2(instr, 1, bases)); break;
+    case op_t::mul: res = _mm_mul_pd(x, load_sse2(instr, 1, bases)); break;
+    case op_t::div: res = _mm_div_pd(x, load_sse2(instr, 1, bases)); break;
+    default: /*neg flips sign bit, as scalar negation does*/
+        res = _mm_xor_pd(x, _mm_set1_pd(-0.0));
+        break;
+    }
+
+    _mm_storeu_pd(slots + instr.dst, res);
+}
+
+__attribute__((target("avx2")))
+__m256d load_avx2(const slp_instruction_t& instr, int j, const double *const *bases) {
+    const operand_t *args = instr.args[j];
+
+    switch(instr.load[j]) {
+    case lane_load_t::contiguous:
+        return _mm256_loadu_pd(&VALUE(args[0]));
+    case lane_load_t::broadcast:
+        return _mm256_set1_pd(VALUE(args[0]));
+    default:
+        return _mm256_set_pd(VALUE(args[3]), VALUE(args[2]), VALUE(args[1]), VALUE(args[0]));
+    }
+}
+
+__attribute__((target("avx2")))
+void run_avx2(const util::vector<slp_instruction_t>& code, double *slots, const double *const *bases) {
+    for(const slp_instruction_t *instr = code.begin(); instr != code.end(); ++instr) {
+        if(instr->width != 4 || !vectorizable(instr->op)) {
+            exec_sse2(*instr, slots, bases);
+            continue;
+        }
+
+        __m256d x = load_avx2(*instr, 0, bases), res;
+        switch(instr->op) {
+        case op_t::add: res = _mm256_add_pd(x, load_avx2(*instr, 1, bases)); break;
+        case op_t::sub: res = _mm256_sub_pd(x, load_avx2(*instr, 1, bases)); break;
+        case op_t::mul: res = _mm256_mul_pd(x, load_avx2(*instr, 1, bases)); break;
+        case op_t::div: res = _mm256_div_pd(x, load_avx2(*instr, 1, bases)); break;
+        default:
+            res = _mm256_xor_pd(x, _mm256_set1_pd(-0.0));
+            break;
+        }
+
+        _mm256_storeu_pd(slots + instr->dst, res);
+    }
+}
+
+#endif
+
+// Reorders [seq] so that nodes of the same operator are adjacent,
+// keeping order of operators' first appearance, and splits it into groups:
+// runs of the same operator are cut into [lanes], 2 and 1 wide groups
+void form_groups(
+    const optimizer::expr_dag_t& dag,
+    util::vector<int>& seq,
+    int lanes,
+    util::vector<int>& widths /*out*/
+) {
+    util::vector<int> sorted;
+    util::vector<bool> taken(seq.size(), false);
+
+    for(int i = 0; i < seq.size(); ++i) {
+        if(taken[i])
+            continue;
+
+        op_t op = dag.get_node(seq[i]).op;
+        int run_size = 0;
+        for(int k = i; k < seq.size(); ++k) {
+            if(!taken[k] && dag.get_node(seq[k]).op == op) {
+                taken[k] = true;
+                sorted.push_back(seq[k]);
+                ++run_size;
+            }
+        }
+
+        for(int width = lanes; width > 0; width /= 2) {
+            for(; run_size >= width; run_size -= width)
+                widths.push_back(width);
+        }
+    }
+
+    seq = sorted;
+}
+
+// How lanes [args] of operand are loaded
+lane_load_t lane_load(const operand_t *args, int width) {
+    bool same = true, adjacent = true;
+    for(int k = 1; k < width; ++k) {
+        same = same && args[k] == args[0];
+        adjacent = adjacent && args[k] == args[0] + k;
+    }
+
+    if(width > 1 && same)
+        return lane_load_t::broadcast;
+    return adjacent ? lane_load_t::contiguous : lane_load_t::gather;
+}
+
+} // namespace
+
+
+slp_program_t::slp_program_t(const bytecode::program_t& prog, isa_t new_isa):
+    num_slots(0),
+    result(0),
+    isa(new_isa == isa_t::avx512 ? isa_t::avx2 : new_isa),
+    is_packed(false)
+{
+    optimizer::expr_dag_t dag;
+    if(!isa_supported(isa) || !optimizer::expr_dag_t::from_program(prog, true, dag))
+        return;
+
+    // slots of variables are those of source program
+    num_slots = prog.get_variables_offset() + prog.get_num_variables();
+
+    const int lanes = isa_lanes(isa);
+
+    // Level of operator: 1 + max level of its operands, constants have level 0
+    // Operators of the same level are independent of each other
+    util::vector<int> level(dag.size(), 0);
+    util::vector<operand_t> operand_of(dag.size(), 0);
+    int top = 0;
+
+    for(int i = 0; i < dag.size(); ++i) {
+        const optimizer::dag_node_t& node = dag.get_node(i);
+        if(node.op == op_t::push_const) {
+            operand_of[i] = bytecode::make_const_operand(constants.size());
+            constants.push_back(node.value);
+            continue;
+        }
+        if(node.op == op_t::load_var) {
+            operand_of[i] = bytecode::make_reg_operand(prog.get_variables_offset() + (int) node.value);
+            continue;
+        }
+
+        for(int j = 0; j < node.num_children; ++j)
+            level[i] = std::max(level[i], level[node.children[j]]);
+        top = std::max(top, ++level[i]);
+    }
+
+    // Lane order of levels is chosen from top to bottom:
+    // operands of every group of level L + 1 become adjacent at level L,
+    // operand by operand, lane by lane
+    util::vector< util::vector<int> > seqs(top + 1);
+    util::vector< util::vector<int> > widths(top + 1);
+    util::vector<bool> placed(dag.size(), false);
+
+    for(int l = top; l >= 1; --l) {
+        util::vector<int>& seq = seqs[l];
+
+        if(l < top) {
+            const util::vector<int>& users = seqs[l + 1];
+            int first = 0;
+            for(int g = 0; g < widths[l + 1].size(); ++g) {
+                int width = widths[l + 1][g];
+                int num_operands = dag.get_node(users[first]).num_children;
+
+                for(int j = 0; j < num_operands; ++j) {
+                    for(int k = 0; k < width; ++k) {
+                        int child = dag.get_node(users[first + k]).children[j];
+                        if(level[child] == l && !placed[child]) {
+                            placed[child] = true;
+                            seq.push_back(child);
+                        }
+                    }
+                }
+                first += width;
+            }
+        }
+
+        // operators, which are used only by higher levels
+        for(int i = 0; i < dag.size(); ++i) {
+            if(level[i] == l && !placed[i]) {
+                placed[i] = true;
+                seq.push_back(i);
+            }
+        }
+
+        form_groups(dag, seq, lanes, widths[l]);
+    }
+
+    // Groups are emitted from bottom to top, so that operands precede users
+    for(int l = 1; l <= top; ++l) {
+        const util::vector<int>& seq = seqs[l];
+        int first = 0;
+
+        for(int g = 0; g < widths[l].size(); ++g) {
+            const optimizer::dag_node_t& lead = dag.get_node(seq[first]);
+
+            slp_instruction_t instr;
+            instr.op = lead.op;
+            instr.width = (std::uint8_t) widths[l][g];
+            instr.num_operands = (std::uint8_t) lead.num_children;
+            instr.dst = num_slots;
+
+            for(int j = 0; j < lead.num_children; ++j) {
+                for(int k = 0; k < instr.width; ++k)
+                    instr.args[j][k] = operand_of[dag.get_node(seq[first + k]).children[j]];
+                instr.load[j] = lane_load(instr.args[j], instr.width);
+            }
+
+            for(int k = 0; k < instr.width; ++k)
+                operand_of[seq[first + k]] = bytecode::make_reg_operand(num_slots++);
+
+            code.push_back(instr);
+            first += instr.width;
+        }
+    }
+
+    result = operand_of[dag.get_root()];
+    is_packed = true;
+}
+
+double slp_program_t::run(double *slots) const {
+    assert(packed());
+
+    const double *bases[2] = { slots, constants.begin() };
+
+    switch(isa) {
+#if POSTFIX_HAS_SIMD
+    case isa_t::avx2:
+        run_avx2(code, slots, bases);
+        break;
+    case isa_t::sse2:
+        for(const slp_instruction_t *instr = code.begin(); instr != code.end(); ++instr)
+            exec_sse2(*instr, slots, bases);
+        break;
+#endif
+    default:
+        for(const slp_instruction_t *instr = code.begin(); instr != code.end(); ++instr)
+            run_lanes(*instr, slots, bases);
+        break;
+    }
+
+    return VALUE(result);
+}
+
+#undef VALUE
+
+} // namespace postfix::simd
@@ -0,0 +1,92 @@
+#ifndef SLP_H
+#define SLP_H
+
+/**
+ * Superword-level parallelism
+ *      Packing of independent operators of the same kind into SIMD lanes
+ *      Vector-register evaluator (SSE2/AVX2), scalar fallback
+*/
+
+#include <cstdint>
+
+#include "bytecode.h"
+#include "register_vm.h"
+#include "expr_dag.h"
+#include "simd.h"
+
+#include "util/vector.h"
+
+namespace postfix::simd {
+
+// widest group of slp_program_t (AVX2)
+const int max_lanes = 4;
+
+// How lanes of operand are brought into vector register
+enum class lane_load_t : std::uint8_t {
+    contiguous,     /*lanes are adjacent values, loaded at once*/
+    broadcast,      /*every lane is the same value*/
+    gather          /*lanes are loaded one by one*/
+};
+
+// Operator, applied to [width] independent lanes at once
+// Results of lanes are stored into adjacent slots, starting at dst
+struct slp_instruction_t {
+    bytecode::opcode_t op;      /*basic operator: add, sub, mul, div, neg, pow, sqrt or fma*/
+    std::uint8_t width;         /*1, 2 or 4 lanes*/
+    std::uint8_t num_operands;
+    lane_load_t load[optimizer::max_node_children];
+    std::uint32_t dst;
+
+    // slot or constant of every lane of every operand (see bytecode::operand_t)
+    bytecode::operand_t args[optimizer::max_node_children][max_lanes];
+};
+
+// Program, in which operators of the same kind at the same depth of expression DAG
+// are packed into vectors, e.g. 4 products of (a*b)+(c*d)+(e*f)+(g*h) form one AVX2 multiplication.
+// Every value has its own slot, following variables of source program (see program_t::get_scratch_size);
+// slots of level are laid out in order of their users' operands,
+// so that operands of next level are mostly loaded at once instead of gathered.
+// Rounding is exactly the one of scalar evaluation: only add, sub, mul, div and neg
+// are vectorized, other operators are computed lane by lane
+class slp_program_t {
+public:
+    slp_program_t(): num_slots(0), result(0), isa(isa_t::scalar), is_packed(false) {}
+
+    // Packs operators of [prog] into vectors of [isa]
+    // AVX-512 packs as AVX2: expressions rarely have 8 independent operators of the same kind
+    explicit slp_program_t(const bytecode::program_t& prog, isa_t isa = native_isa());
+
+    // false, if program could not be packed (e.g. it is invalid)
+    bool packed() const {
+        return is_packed;
+    }
+
+    isa_t get_isa() const {
+        return isa;
+    }
+
+    // number of values required by run
+    int get_num_slots() const {
+        return num_slots;
+    }
+
+    const util::vector<slp_instruction_t>& get_code() const {
+        return code;
+    }
+
+    // [slots] must hold at least get_num_slots() values
+    double run(double *slots) const;
+
+private:
+    util::vector<slp_instruction_t> code;
+    util::vector<double> constants;
+
+    int num_slots;
+    bytecode::operand_t result; /*operand holding value of expression*/
+    isa_t isa;
+    bool is_packed;
+};
+
+} // namespace postfix::simd
+
+#endif
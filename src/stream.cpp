@@ -0,0 +1,96 @@
+#include "stream.h"
+
+#include "lexer.h"
+
+namespace postfix {
+
+stream_converter_t::stream_converter_t(const postfix_converter_t& new_converter, const sink_t& new_sink):
+    converter(new_converter.clone()),
+    sink(new_sink)
+{
+    reset();
+}
+
+void stream_converter_t::reset() {
+    pending.clear();
+    while(!st.empty())
+        st.pop();
+    ctx = token_conversion_ctx();
+    released.clear();
+
+    // left_parenthesis can be placed after left_parenthesis
+    prev_token = builder::left_parenthesis();
+    started = false;
+}
+
+void stream_converter_t::feed(std::string_view chunk) {
+    try {
+        pending.append(chunk.data(), chunk.size());
+        convert_pending(false);
+    } catch(...) {
+        reset();
+        throw;
+    }
+}
+
+void stream_converter_t::finish() {
+    try {
+        convert_pending(true);
+
+        candidate_tokens.clear();
+        candidate_tokens.push_back(builder::right_paranthesis());
+        place_token();
+
+        if(!ctx.is_valid())
+            throw std::logic_error("invalid parenthesis");
+    } catch(...) {
+        reset();
+        throw;
+    }
+
+    reset();
+}
+
+void stream_converter_t::place_token() {
+    token_t cur_token = detail::prune_tokens(prev_token, candidate_tokens);
+    cur_token.influence_ctx(ctx);
+    cur_token.expr_push(released, st);
+    prev_token = cur_token;
+
+    for(int i = 0; i < released.size(); ++i)
+        sink(released[i]);
+    released.clear();
+}
+
+void stream_converter_t::convert_pending(bool is_last) {
+    // input is enclosed in parentheses, as by postfix_converter_t::convert
+    if(!started) {
+        candidate_tokens.clear();
+        candidate_tokens.push_back(builder::left_parenthesis());
+        place_token();
+        started = true;
+    }
+
+    detail::postfix_converter_impl_t& impl = converter.impl;
+    const int lookahead = impl.get_max_lookahead();
+
+    const char *beg = pending.data(), *end = pending.data() + pending.size();
+    for(beg = lexer::skip_spaces(beg, end); beg != end; beg = lexer::skip_spaces(beg, end)) {
+        // token may continue in the next chunk, unless lexer has seen enough characters after it
+        const char *word_end = lexer::skip(beg, end, lexer::identifier | lexer::dot);
+        if(!is_last && end - word_end < lookahead)
+            break;
+
+        candidate_tokens.clear();
+        const char *token_end = impl.get_token_candidates(beg, end, candidate_tokens);
+        if(!is_last && token_end == end)
+            break;
+
+        place_token();
+        beg = token_end;
+    }
+
+    pending.erase(0, beg - pending.data());
+}
+
+} // namespace postfix
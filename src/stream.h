@@ -0,0 +1,78 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+/**
+ * Streaming conversion
+ *      Input arrives in chunks, postfix tokens leave through sink as soon as they are known
+*/
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "postfix.h"
+
+#include "util/stack.h"
+#include "util/vector.h"
+
+namespace postfix {
+
+// Push-based converter of single expression, arriving in chunks
+//
+// Chunks are lexed as they are fed. Token, which may continue in the next chunk
+// (e.g. digits of number, name of function or variable, exponent without its digits),
+// is kept until there is enough input to decide it, so that chunks may be split anywhere.
+// Tokens are placed by the same rules as by postfix_converter_t::convert,
+// and tokens of postfix expression are passed to sink, once operator stack releases them.
+// Thus converter holds the operator stack (bounded by nesting depth) and the last,
+// undecided token, rather than whole input
+//
+// Sequence of tokens, passed to sink, is postfix expression of postfix_converter_t::convert
+class stream_converter_t {
+public:
+    // receives tokens of postfix expression in order
+    typedef std::function<void(token_t&)> sink_t;
+
+    // Converts by the rules of copy of [converter] (its functions and variables)
+    stream_converter_t(const postfix_converter_t& converter, const sink_t& sink);
+
+    // appends [chunk] to expression
+    // Throws, if expression is invalid already; converter is reset then
+    void feed(std::string_view chunk);
+
+    // completes expression, converter is ready for the next one
+    // Throws, if expression is invalid; converter is reset as well
+    void finish();
+
+    // discards expression, fed so far
+    void reset();
+
+    // input and tokens, held by converter: undecided token and operator stack
+    int get_buffered_size() const {
+        return pending.size() + st.size();
+    }
+
+private:
+    postfix_converter_t converter;
+    sink_t sink;
+
+    std::string pending; /*input, which is not converted yet*/
+    util::stack<token_t> st;
+    token_conversion_ctx ctx;
+    token_t prev_token;
+    bool started; /*implicit opening parenthesis is placed*/
+
+    // buffers
+    util::vector<token_t> candidate_tokens;
+    util::vector<token_t> released;
+
+    // converts tokens of pending, which can be decided; all of them, if [is_last]
+    void convert_pending(bool is_last);
+
+    // places the first of candidate_tokens, which fits, and passes released tokens to sink
+    void place_token();
+};
+
+} // namespace postfix
+
+#endif
@@ -0,0 +1,186 @@
+#include "strength_reduction.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+std::string format_number(double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", value);
+    return buf;
+}
+
+void report(util::vector<rewrite_t> *rewrites, const char *rule, const std::string& description) {
+    if(rewrites == NULL)
+        return;
+
+    rewrite_t rewrite = { rule, description };
+    rewrites->push_back(rewrite);
+}
+
+// x^n, n > 0, by repeated squaring
+// Squares are the same node, so they are emitted as dup
+int power_chain(expr_dag_t& dag, int x, int n, int& num_mul /*out*/) {
+    int res = -1;
+    int square = x;
+    num_mul = 0;
+
+    while(true) {
+        if(n & 1) {
+            if(res < 0) {
+                res = square;
+            } else {
+                res = dag.make_binary(op_t::mul, res, square);
+                ++num_mul;
+            }
+        }
+
+        n >>= 1;
+        if(n == 0)
+            break;
+
+        square = dag.make_binary(op_t::mul, square, square);
+        ++num_mul;
+    }
+
+    return res;
+}
+
+// true, if node is constant or negated constant (e.g. exponent of exp(x, -1))
+bool get_constant(const expr_dag_t& dag, int idx, double& value /*out*/) {
+    bool negated = false;
+    while(dag.get_node(idx).op == op_t::neg) {
+        negated = !negated;
+        idx = dag.get_node(idx).children[0];
+    }
+
+    const dag_node_t& node = dag.get_node(idx);
+    value = negated ? -node.value : node.value;
+    return node.op == op_t::push_const;
+}
+
+// 1 / c is exactly representable, so that x / c == x * (1 / c)
+bool has_exact_reciprocal(double c) {
+    int exponent;
+    double mantissa = std::frexp(c, &exponent);
+
+    return std::isnormal(c) && std::isnormal(1.0 / c) && std::fabs(mantissa) == 0.5;
+}
+
+// Node, replacing exp(x, e), or -1, if it is left as is
+int reduce_pow(
+    expr_dag_t& dag, int x, double e,
+    bool relaxed_precision,
+    util::vector<rewrite_t> *rewrites
+) {
+    const std::string before = "exp(x, " + format_number(e) + ")";
+
+    if(e == 0) { /*even exp(NaN, 0) is 1*/
+        report(rewrites, "pow_to_const", before + " -> 1");
+        return dag.make_const(1);
+    }
+
+    if(e == 1) {
+        report(rewrites, "pow_to_identity", before + " -> x");
+        return x;
+    }
+
+    if(e == 0.5) {
+        report(rewrites, "pow_to_sqrt", before + " -> sqrt(x)");
+        return dag.make_unary(op_t::sqrt, x);
+    }
+
+    if(e != std::floor(e) || std::fabs(e) > max_reduced_exponent)
+        return -1;
+
+    // pow is not correctly rounded, so even x * x and 1 / x may differ from it in the last bit
+    if(!relaxed_precision)
+        return -1;
+
+    int n = (int) std::fabs(e);
+
+    int num_mul;
+    int res = power_chain(dag, x, n, num_mul);
+    std::string after = std::to_string(num_mul) + " multiplications";
+
+    if(e < 0) {
+        res = dag.make_binary(op_t::div, dag.make_const(1), res);
+        after = num_mul == 0 ? "1 / x" : "1 / (" + after + ")";
+    }
+
+    report(rewrites, "pow_to_mul", before + " -> " + after);
+    return res;
+}
+
+// Node, replacing x / c, or -1, if it is left as is
+int reduce_div(
+    expr_dag_t& dag, int x, double c,
+    bool relaxed_precision,
+    util::vector<rewrite_t> *rewrites
+) {
+    double reciprocal = 1.0 / c;
+    // reciprocal of huge or tiny constant loses precision or overflows
+    if(!std::isnormal(c) || !std::isnormal(reciprocal))
+        return -1;
+
+    if(!relaxed_precision && !has_exact_reciprocal(c))
+        return -1;
+
+    report(rewrites, "div_to_mul",
+        "x / " + format_number(c) + " -> x * " + format_number(reciprocal));
+    return dag.make_binary(op_t::mul, x, dag.make_const(reciprocal));
+}
+
+} // namespace
+
+
+expr_dag_t reduce_strength(
+    const expr_dag_t& dag,
+    bool relaxed_precision,
+    util::vector<rewrite_t> *rewrites
+) {
+    expr_dag_t res(dag.hash_consing());
+    if(dag.get_root() < 0)
+        return res;
+
+    // node of res, replacing node of dag
+    util::vector<int> node_map(dag.size(), -1);
+
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+
+        if(node.op == op_t::push_const) {
+            node_map[i] = res.make_const(node.value);
+            continue;
+        }
+        if(node.op == op_t::load_var) {
+            node_map[i] = res.make_var((std::uint32_t) node.value);
+            continue;
+        }
+
+        int children[max_node_children];
+        for(int j = 0; j < node.num_children; ++j)
+            children[j] = node_map[node.children[j]];
+
+        int reduced = -1;
+        double constant;
+        if(node.num_children == 2 && get_constant(dag, node.children[1], constant)) {
+            if(node.op == op_t::pow)
+                reduced = reduce_pow(res, children[0], constant, relaxed_precision, rewrites);
+            else if(node.op == op_t::div)
+                reduced = reduce_div(res, children[0], constant, relaxed_precision, rewrites);
+        }
+
+        node_map[i] = reduced >= 0 ? reduced : res.make_node(node.op, node.num_children, children);
+    }
+
+    res.set_root(node_map[dag.get_root()]);
+    return res;
+}
+
+} // namespace postfix::optimizer
@@ -0,0 +1,37 @@
+#ifndef STRENGTH_REDUCTION_H
+#define STRENGTH_REDUCTION_H
+
+/**
+ * Strength reduction over expression DAG
+ *      Powers with constant exponent -> multiplications, sqrt
+ *      Division by constant -> multiplication by reciprocal
+*/
+
+#include "expr_dag.h"
+
+#include "util/vector.h"
+
+namespace postfix::optimizer {
+
+// Largest |exponent|, which is turned into multiplications
+const int max_reduced_exponent = 64;
+
+// Returns [dag] with operators replaced by cheaper ones
+// Exact rewrites are always performed:
+//      exp(x, 0) -> 1, exp(x, 1) -> x,
+//      exp(x, 0.5) -> sqrt(x) (see bytecode::pow_half),
+//      x / c -> x * (1 / c), if c is power of two
+// [relaxed_precision] allows rewrites, which may change result in last bits:
+//      other integer exponents (even exp(x, 2) -> x * x and exp(x, -1) -> 1 / x,
+//      as pow is not correctly rounded) -> multiplications by repeated squaring,
+//      x / c -> x * (1 / c) for any finite nonzero c
+// Every rewrite is appended to [rewrites], if it is not NULL
+expr_dag_t reduce_strength(
+    const expr_dag_t& dag,
+    bool relaxed_precision,
+    util::vector<rewrite_t> *rewrites /*out*/
+);
+
+} // namespace postfix::optimizer
+
+#endif
@@ -0,0 +1,194 @@
+#include "subtrees.h"
+
+#include <algorithm>
+#include <cassert>
+#include <queue>
+#include <utility>
+
+namespace postfix::parallel {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+typedef bytecode::instruction_t instruction_t;
+
+// Subtrees of code: node of every instruction spans [start[i], i]
+// Node is self-contained, if values, it exchanges through temporaries and dup,
+// are produced and consumed within it
+struct subtree_info_t {
+    util::vector<int> start;
+    util::vector<bool> self_contained;
+};
+
+// Operands of node, which are nodes themselves
+// dup is a leaf, which depends on node before it; store_tmp passes its operand through
+int num_children(op_t op) {
+    return op == op_t::dup ? 0 : bytecode::opcode_num_operands(op);
+}
+
+subtree_info_t analyze(const bytecode::program_t& prog) {
+    const util::vector<instruction_t>& code = prog.get_code();
+    const int n = code.size();
+
+    // first and last instruction, which touches temporary
+    util::vector<int> first_touch(prog.get_num_temps(), n), last_touch(prog.get_num_temps(), -1);
+    for(int i = 0; i < n; ++i) {
+        if(code[i].op == op_t::store_tmp || code[i].op == op_t::load_tmp) {
+            first_touch[code[i].arg] = std::min(first_touch[code[i].arg], i);
+            last_touch[code[i].arg] = std::max(last_touch[code[i].arg], i);
+        }
+    }
+
+    subtree_info_t res;
+    res.start = util::vector<int>(n, 0);
+    res.self_contained = util::vector<bool>(n, false);
+
+    // lowest and highest instruction, which node depends on or is depended on by
+    util::vector<int> lo(n, 0), hi(n, 0);
+    util::vector<int> roots; /*stack of nodes, whose values are on stack*/
+
+    for(int i = 0; i < n; ++i) {
+        const instruction_t& instr = code[i];
+        int c = num_children(instr.op);
+
+        res.start[i] = i;
+        lo[i] = i;
+        hi[i] = i;
+
+        for(int k = 0; k < c; ++k) {
+            int child = roots[roots.size() - 1];
+            roots.pop_back();
+
+            res.start[i] = res.start[child];
+            lo[i] = std::min(lo[i], lo[child]);
+            hi[i] = std::max(hi[i], hi[child]);
+        }
+
+        if(instr.op == op_t::dup) {
+            int source = roots[roots.size() - 1];
+            lo[i] = res.start[source];
+        } else if(instr.op == op_t::store_tmp || instr.op == op_t::load_tmp) {
+            lo[i] = std::min(lo[i], first_touch[instr.arg]);
+            hi[i] = std::max(hi[i], last_touch[instr.arg]);
+        }
+
+        res.self_contained[i] = lo[i] >= res.start[i] && hi[i] <= i;
+        roots.push_back(i);
+    }
+
+    assert(roots.size() == 1);
+    return res;
+}
+
+} // namespace
+
+
+subtree_program_t::subtree_program_t(const bytecode::program_t& prog, int min_task_size, int max_tasks):
+    num_vars(prog.get_num_variables())
+{
+    assert(prog.valid());
+    const util::vector<instruction_t>& code = prog.get_code();
+    const int n = code.size();
+    if(n < 2 * min_task_size)
+        return;
+
+    subtree_info_t info = analyze(prog);
+
+    // Frontier of subtrees (size, root), the largest on top
+    std::priority_queue< std::pair<int, int> > frontier;
+    int num_large = 1; /*subtrees in frontier of at least min_task_size instructions*/
+    frontier.push(std::make_pair(n, n - 1));
+
+    util::vector<int> roots; /*of tasks*/
+
+    while(!frontier.empty() && frontier.top().first >= min_task_size) {
+        int root = frontier.top().second;
+        frontier.pop();
+        --num_large;
+
+        // operands of root tile its range, the last one ends right before it
+        util::vector<int> children;
+        int large_children = 0;
+        for(int k = 0, end = root - 1; k < num_children(code[root].op); ++k) {
+            children.push_back(end);
+            large_children += end - info.start[end] + 1 >= min_task_size;
+            end = info.start[end] - 1;
+        }
+
+        // subtree is kept whole, if splitting it gives nothing large
+        // or there are enough tasks already
+        if(info.self_contained[root]
+            && (large_children == 0 || roots.size() + num_large + 1 >= max_tasks)) {
+            roots.push_back(root);
+            continue;
+        }
+
+        for(int k = 0; k < children.size(); ++k) {
+            int child = children[k];
+            frontier.push(std::make_pair(child - info.start[child] + 1, child));
+        }
+        num_large += large_children;
+    }
+
+    // single task would only add overhead
+    if(roots.size() < 2)
+        return;
+
+    std::sort(roots.begin(), roots.end());
+
+    int k = 0;
+    for(int i = 0; i < n; ++i) {
+        if(k < roots.size() && i == info.start[roots[k]]) {
+            bytecode::program_t task;
+            for(; i <= roots[k]; ++i)
+                task.append(prog, code[i]);
+            --i;
+
+            assert(task.valid());
+            tasks.push_back(task);
+            combine.load_var(num_vars + k);
+            ++k;
+            continue;
+        }
+
+        combine.append(prog, code[i]);
+    }
+
+    assert(combine.valid());
+}
+
+double subtree_program_t::run(thread_pool_t& pool, const double *values) {
+    assert(split());
+
+    // any worker may run any task
+    if(task_st.size() != pool.get_num_workers()) {
+        int scratch_size = 0;
+        for(int k = 0; k < tasks.size(); ++k)
+            scratch_size = std::max(scratch_size, tasks[k].get_scratch_size());
+
+        task_st = util::vector< util::vector<double> >(pool.get_num_workers());
+        for(int w = 0; w < task_st.size(); ++w)
+            task_st[w] = util::vector<double>(scratch_size);
+    }
+    if(combine_st.size() < combine.get_scratch_size())
+        combine_st = util::vector<double>(combine.get_scratch_size());
+
+    // variables of program, followed by results of tasks, are variables of combining program
+    if(num_vars > 0)
+        std::copy(values, values + num_vars, combine_st.begin() + combine.get_variables_offset());
+
+    // lambda captures two pointers, so that std::function keeps it without allocation
+    pool.parallel_for(tasks.size(), [this, values](int worker, int k) {
+        const bytecode::program_t& task = tasks[k];
+        util::vector<double>& scratch = task_st[worker];
+        if(task.get_num_variables() > 0)
+            std::copy(values, values + task.get_num_variables(), scratch.begin() + task.get_variables_offset());
+
+        double result = bytecode::interpret(task, scratch.begin());
+        combine_st[combine.get_variables_offset() + num_vars + k] = result;
+    });
+
+    return bytecode::interpret(combine, combine_st.begin());
+}
+
+} // namespace postfix::parallel
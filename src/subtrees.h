@@ -0,0 +1,77 @@
+#ifndef SUBTREES_H
+#define SUBTREES_H
+
+/**
+ * Parallel evaluation of large expressions
+ *      Independent subtrees of program become tasks of thread pool
+ *      Combining program takes their results as variables
+*/
+
+#include "bytecode.h"
+#include "thread_pool.h"
+
+#include "util/vector.h"
+
+namespace postfix::parallel {
+
+// Program, split into independent subtrees
+//
+// Subtree of postfix code is contiguous range, ending with its root operator.
+// Starting from root of program, the largest subtree is repeatedly replaced by its operands
+// (function arguments, operands of top-level operators), until there are [max_tasks] subtrees
+// of at least [min_task_size] instructions, or there is nothing large left to split.
+// Such subtrees become tasks, the rest of program combines their results.
+// Subtree, which shares temporaries (common subexpressions) with the rest of program,
+// is split further or left in combining program.
+//
+// Each task evaluates its subtree in the same order as whole program does,
+// so that result is identical to serial evaluation
+class subtree_program_t {
+public:
+    static const int default_min_task_size = 4096;
+    static const int default_max_tasks = 256;
+
+    subtree_program_t(): num_vars(0) {}
+
+    // [prog] must be valid
+    explicit subtree_program_t(
+        const bytecode::program_t& prog,
+        int min_task_size = default_min_task_size,
+        int max_tasks = default_max_tasks
+    );
+
+    // true, if program is split into tasks; otherwise it must be evaluated serially
+    bool split() const {
+        return !tasks.empty();
+    }
+
+    int get_num_tasks() const {
+        return tasks.size();
+    }
+
+    const bytecode::program_t& get_task(int idx) const {
+        return tasks[idx];
+    }
+
+    // program, where result of task k is variable num_variables + k
+    const bytecode::program_t& get_combine() const {
+        return combine;
+    }
+
+    // Evaluates tasks on [pool] and combines their results
+    // Variable of slot v is values[v]; [values] may be NULL, if program has no variables
+    double run(thread_pool_t& pool, const double *values);
+
+private:
+    util::vector<bytecode::program_t> tasks; /*in order of code*/
+    bytecode::program_t combine;
+    int num_vars; /*of source program*/
+
+    // buffers of run
+    util::vector< util::vector<double> > task_st; /*per worker*/
+    util::vector<double> combine_st;
+};
+
+} // namespace postfix::parallel
+
+#endif
@@ -0,0 +1,224 @@
+#include "superinstructions.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace postfix::bytecode {
+
+/* Catalog */
+
+const superinstruction_info_t& get_superinstruction_info(superinstruction_t id) {
+    typedef opcode_t op;
+
+    // indexed by superinstruction_t
+    static const superinstruction_info_t catalog[] = {
+        { superinstruction_t::add_imm, "add_imm",
+            { op::push_const, op::add }, 2, op::add_imm },
+        { superinstruction_t::sub_imm, "sub_imm",
+            { op::push_const, op::sub }, 2, op::sub_imm },
+        { superinstruction_t::mul_imm, "mul_imm",
+            { op::push_const, op::mul }, 2, op::mul_imm },
+        { superinstruction_t::div_imm, "div_imm",
+            { op::push_const, op::div }, 2, op::div_imm },
+        { superinstruction_t::pow_imm, "pow_imm",
+            { op::push_const, op::pow }, 2, op::pow_imm },
+        { superinstruction_t::neg_const, "neg_const",
+            { op::push_const, op::neg }, 2, op::push_const },
+        { superinstruction_t::mul_imm_add, "mul_imm_add",
+            { op::push_const, op::mul, op::add }, 3, op::mul_imm_add },
+        { superinstruction_t::mul_imm_sub, "mul_imm_sub",
+            { op::push_const, op::mul, op::sub }, 3, op::mul_imm_sub }
+    };
+    static_assert(
+        sizeof(catalog) / sizeof(catalog[0]) == (int) superinstruction_t::count,
+        "get_superinstruction_info: every superinstruction must be described"
+    );
+
+    return catalog[(int) id];
+}
+
+superinstruction_set_t superinstruction_set_t::all() {
+    superinstruction_set_t set;
+    for(int i = 0; i < (int) superinstruction_t::count; ++i)
+        set.enable((superinstruction_t) i);
+
+    return set;
+}
+
+
+/* Fusion */
+
+// Superinstruction with immediate, which replaces push_const [op]
+static bool find_imm_superinstruction(opcode_t op, superinstruction_t& id /*out*/) {
+    for(int i = 0; i < (int) superinstruction_t::count; ++i) {
+        const superinstruction_info_t& info = get_superinstruction_info((superinstruction_t) i);
+        if(info.pattern_size == 2 && info.pattern[1] == op && info.fused != opcode_t::push_const) {
+            id = info.id;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+program_t fuse_superinstructions(const program_t& prog, const superinstruction_set_t& set) {
+    if(!prog.valid() || set.empty())
+        return prog;
+
+    program_t res;
+    const util::vector<instruction_t>& code = prog.get_code();
+
+    // constant, which is not emitted yet, as it may be fused with following operators
+    bool has_pending = false;
+    double pending = 0;
+
+    for(int i = 0; i < code.size(); ++i) {
+        const instruction_t& instr = code[i];
+
+        if(instr.op == opcode_t::push_const) {
+            if(has_pending)
+                res.push_constant(pending);
+
+            has_pending = true;
+            pending = prog.get_constants()[instr.arg];
+            continue;
+        }
+
+        if(has_pending) {
+            // negation of constant is exact, fold it into constant
+            if(instr.op == opcode_t::neg && set.contains(superinstruction_t::neg_const)) {
+                pending = -pending;
+                continue;
+            }
+
+            // push_const mul add/sub
+            if(instr.op == opcode_t::mul && i + 1 < code.size()) {
+                opcode_t next = code[i + 1].op;
+                superinstruction_t id = next == opcode_t::add ?
+                    superinstruction_t::mul_imm_add : superinstruction_t::mul_imm_sub;
+
+                if((next == opcode_t::add || next == opcode_t::sub) && set.contains(id)) {
+                    const superinstruction_info_t& info = get_superinstruction_info(id);
+                    res.apply_imm(info.fused, pending, 2, info.name);
+                    has_pending = false;
+                    ++i;
+                    continue;
+                }
+            }
+
+            // push_const op
+            superinstruction_t id;
+            if(find_imm_superinstruction(instr.op, id) && set.contains(id)) {
+                const superinstruction_info_t& info = get_superinstruction_info(id);
+                res.apply_imm(info.fused, pending, 1, info.name);
+                has_pending = false;
+                continue;
+            }
+
+            res.push_constant(pending);
+            has_pending = false;
+        }
+
+        res.append(prog, instr);
+    }
+
+    if(has_pending)
+        res.push_constant(pending);
+
+    assert(res.valid());
+    return res;
+}
+
+
+/* ngram_profiler_t */
+
+void ngram_profiler_t::record(const program_t& prog) {
+    const util::vector<instruction_t>& code = prog.get_code();
+    num_instructions += code.size();
+
+    for(int i = 0; i < code.size(); ++i) {
+        ngram_t ngram;
+        ngram.push_back(code[i].op);
+
+        for(int size = 2; size <= max_pattern_size && i + size <= code.size(); ++size) {
+            ngram.push_back(code[i + size - 1].op);
+
+            std::string key = to_string(ngram);
+            std::map< std::string, ngram_count_t >::iterator it = counts.find(key);
+            if(it == counts.end()) {
+                ngram_count_t entry = { ngram, 0 };
+                it = counts.insert(std::make_pair(key, entry)).first;
+            }
+
+            ++it->second.count;
+        }
+    }
+}
+
+util::vector<ngram_profiler_t::ngram_count_t> ngram_profiler_t::top(int max_num) const {
+    util::vector<ngram_count_t> res;
+    for(
+        std::map< std::string, ngram_count_t >::const_iterator it = counts.begin();
+        it != counts.end();
+        ++it
+    )
+        res.push_back(it->second);
+
+    std::stable_sort(res.begin(), res.end(),
+        [](const ngram_count_t& a, const ngram_count_t& b) {
+            return a.count > b.count;
+        });
+
+    while(res.size() > max_num)
+        res.pop_back();
+
+    return res;
+}
+
+long ngram_profiler_t::get_count(const ngram_t& ngram) const {
+    std::map< std::string, ngram_count_t >::const_iterator it = counts.find(to_string(ngram));
+    return it == counts.end() ? 0 : it->second.count;
+}
+
+superinstruction_set_t ngram_profiler_t::select(int max_size, double min_share) const {
+    // pairs of (count, superinstruction)
+    util::vector< std::pair<long, int> > candidates;
+
+    for(int i = 0; i < (int) superinstruction_t::count; ++i) {
+        const superinstruction_info_t& info = get_superinstruction_info((superinstruction_t) i);
+
+        ngram_t pattern;
+        for(int j = 0; j < info.pattern_size; ++j)
+            pattern.push_back(info.pattern[j]);
+
+        long count = get_count(pattern);
+        if(count == 0 || count < min_share * num_instructions)
+            continue;
+
+        candidates.push_back(std::make_pair(count, i));
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [](const std::pair<long, int>& a, const std::pair<long, int>& b) {
+            return a.first > b.first;
+        });
+
+    superinstruction_set_t set;
+    for(int i = 0; i < candidates.size() && i < max_size; ++i)
+        set.enable((superinstruction_t) candidates[i].second);
+
+    return set;
+}
+
+std::string ngram_profiler_t::to_string(const ngram_t& ngram) {
+    std::string res;
+    for(int i = 0; i < ngram.size(); ++i) {
+        if(i != 0)
+            res += ' ';
+        res += opcode_name(ngram[i]);
+    }
+
+    return res;
+}
+
+} // namespace postfix::bytecode
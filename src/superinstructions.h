@@ -0,0 +1,125 @@
+#ifndef SUPERINSTRUCTIONS_H
+#define SUPERINSTRUCTIONS_H
+
+/**
+ * Superinstructions
+ *      Catalog of fusable opcode sequences
+ *      Fusion pass
+ *      N-gram profiler, deriving superinstruction set from corpus of programs
+*/
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "bytecode.h"
+
+#include "util/vector.h"
+
+namespace postfix::bytecode {
+
+// Superinstructions, known to interpreters
+enum class superinstruction_t {
+    add_imm,        /*push_const add -> add_imm*/
+    sub_imm,        /*push_const sub -> sub_imm*/
+    mul_imm,        /*push_const mul -> mul_imm*/
+    div_imm,        /*push_const div -> div_imm*/
+    pow_imm,        /*push_const pow -> pow_imm*/
+    neg_const,      /*push_const neg -> push_const of negated constant*/
+    mul_imm_add,    /*push_const mul add -> mul_imm_add*/
+    mul_imm_sub,    /*push_const mul sub -> mul_imm_sub*/
+    count
+};
+
+const int max_pattern_size = 3;
+
+// Description of superinstruction
+struct superinstruction_info_t {
+    superinstruction_t id;
+    const char *name;
+    opcode_t pattern[max_pattern_size];
+    int pattern_size;
+    opcode_t fused; /*resulting opcode*/
+};
+
+// Catalog of all superinstructions, indexed by superinstruction_t
+const superinstruction_info_t& get_superinstruction_info(superinstruction_t id);
+
+// Set of enabled superinstructions
+class superinstruction_set_t {
+public:
+    superinstruction_set_t(): mask(0) {}
+
+    static superinstruction_set_t all();
+    static superinstruction_set_t none() {
+        return superinstruction_set_t();
+    }
+
+    void enable(superinstruction_t id) {
+        mask |= bit(id);
+    }
+
+    void disable(superinstruction_t id) {
+        mask &= ~bit(id);
+    }
+
+    bool contains(superinstruction_t id) const {
+        return (mask & bit(id)) != 0;
+    }
+
+    bool empty() const {
+        return mask == 0;
+    }
+
+    bool operator==(const superinstruction_set_t& other) const {
+        return mask == other.mask;
+    }
+
+private:
+    std::uint32_t mask;
+
+    static std::uint32_t bit(superinstruction_t id) {
+        return 1u << (int) id;
+    }
+};
+
+// Rewrites sequences of [prog] into enabled superinstructions
+// Longer patterns are preferred. Invalid programs are returned as is
+program_t fuse_superinstructions(const program_t& prog, const superinstruction_set_t& set);
+
+// Counts opcode n-grams of recorded programs
+class ngram_profiler_t {
+public:
+    typedef util::vector<opcode_t> ngram_t;
+
+    ngram_profiler_t(): num_instructions(0) {}
+
+    struct ngram_count_t {
+        ngram_t ngram;
+        long count;
+    };
+
+    // Count all n-grams of size 2..max_pattern_size in [prog]
+    void record(const program_t& prog);
+
+    // [max_num] most frequent n-grams, the most frequent first
+    util::vector<ngram_count_t> top(int max_num) const;
+
+    // Number of occurrences of [ngram]
+    long get_count(const ngram_t& ngram) const;
+
+    // Superinstructions, whose patterns occur in at least [min_share] of recorded
+    // instructions, at most [max_size] of them, the most frequent are preferred
+    superinstruction_set_t select(int max_size, double min_share = 0.0) const;
+
+    // Human-readable form of n-gram, e.g. "push_const mul"
+    static std::string to_string(const ngram_t& ngram);
+
+private:
+    std::map< std::string, ngram_count_t > counts;
+    long num_instructions;
+};
+
+} // namespace postfix::bytecode
+
+#endif
@@ -0,0 +1,182 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace postfix::parallel {
+
+/* worker_t */
+
+bool thread_pool_t::worker_t::pop_back(range_t& out) {
+    std::lock_guard<std::mutex> guard(lock);
+    if(ranges.empty())
+        return false;
+
+    out = ranges.back();
+    ranges.pop_back();
+    return true;
+}
+
+bool thread_pool_t::worker_t::steal_front(range_t& out) {
+    std::lock_guard<std::mutex> guard(lock);
+    if(ranges.empty())
+        return false;
+
+    out = ranges.front();
+    ranges.pop_front();
+    return true;
+}
+
+void thread_pool_t::worker_t::push_back(const range_t& range) {
+    std::lock_guard<std::mutex> guard(lock);
+    ranges.push_back(range);
+}
+
+
+/* thread_pool_t */
+
+thread_pool_t::thread_pool_t(int new_num_workers):
+    num_workers(new_num_workers > 0 ? new_num_workers : std::max(1, (int) std::thread::hardware_concurrency())),
+    workers(new worker_t[num_workers]),
+    generation(0),
+    stop(false),
+    active(0),
+    func(NULL),
+    grain(1),
+    remaining(0),
+    unclaimed(0),
+    error_task(-1)
+{
+    // worker 0 is thread, calling parallel_for
+    for(int w = 1; w < num_workers; ++w)
+        threads.push_back(std::thread(&thread_pool_t::thread_main, this, w));
+}
+
+thread_pool_t::~thread_pool_t() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    wake.notify_all();
+
+    for(int i = 0; i < (int) threads.size(); ++i)
+        threads[i].join();
+}
+
+void thread_pool_t::parallel_for(int num_tasks, const std::function<void(int, int)>& new_func, int new_grain) {
+    if(num_tasks <= 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        func = &new_func;
+        grain = std::max(1, new_grain);
+        remaining = num_tasks;
+        unclaimed = num_tasks;
+        error_task = -1;
+        error = NULL;
+
+        // contiguous share of tasks per worker
+        for(int w = 0; w < num_workers; ++w) {
+            range_t share = {
+                (int) ((long long) num_tasks * w / num_workers),
+                (int) ((long long) num_tasks * (w + 1) / num_workers)
+            };
+            if(share.begin != share.end)
+                workers[w].push_back(share);
+        }
+
+        ++generation;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::exception_ptr res;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [this] { return remaining == 0 && active == 0; });
+        func = NULL;
+        res = error;
+        error = NULL;
+    }
+
+    if(res)
+        std::rethrow_exception(res);
+}
+
+void thread_pool_t::thread_main(int worker) {
+    unsigned seen = 0;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this, seen] { return stop || generation != seen; });
+            if(stop)
+                return;
+
+            seen = generation;
+            ++active;
+        }
+
+        work(worker);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if(--active == 0)
+                finished.notify_all();
+        }
+    }
+}
+
+void thread_pool_t::work(int worker) {
+    range_t range;
+
+    while(true) {
+        bool found = workers[worker].pop_back(range);
+
+        // victims are visited starting from the next worker, so that thieves spread out
+        for(int k = 1; !found && k < num_workers; ++k)
+            found = workers[(worker + k) % num_workers].steal_front(range);
+
+        // Deques may be empty only for a moment, while owner splits range it has taken:
+        // worker gives up, when every task is taken by someone
+        if(!found) {
+            if(unclaimed == 0)
+                return;
+
+            std::this_thread::yield();
+            continue;
+        }
+
+        run_range(worker, range);
+    }
+}
+
+void thread_pool_t::run_range(int worker, range_t range) {
+    // lazy splitting: halves are left to thieves, the largest ones are at front of deque
+    while(range.end - range.begin > grain) {
+        int mid = range.begin + (range.end - range.begin) / 2;
+        range_t upper = { mid, range.end };
+        workers[worker].push_back(upper);
+        range.end = mid;
+    }
+
+    // claimed only after halves are pushed, so that thieves see them before they may give up
+    unclaimed -= range.end - range.begin;
+
+    for(int task = range.begin; task < range.end; ++task) {
+        try {
+            (*func)(worker, task);
+        } catch(...) {
+            std::lock_guard<std::mutex> guard(lock);
+            if(error_task == -1 || task < error_task) {
+                error_task = task;
+                error = std::current_exception();
+            }
+        }
+    }
+
+    remaining -= range.end - range.begin;
+}
+
+} // namespace postfix::parallel
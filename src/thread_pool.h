@@ -0,0 +1,98 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/**
+ * Thread pool with work stealing
+ *      Deque of ranges of tasks per worker
+ *      Owner splits its range in halves, thieves take the largest one
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace postfix::parallel {
+
+// Pool of threads, running loops over independent tasks
+//
+// Tasks [0, num_tasks) of loop are split into ranges; each worker starts with
+// contiguous share of them in its own deque. Worker takes range from back of
+// its deque and halves it, leaving the other half to thieves, until range is not larger than grain.
+// Idle worker steals from front of deque of other worker, where the largest ranges reside,
+// so that workload stays balanced, even if costs of tasks are highly skewed.
+//
+// Thread, calling parallel_for, is worker 0; pool starts num_workers - 1 threads
+class thread_pool_t {
+public:
+    // [num_workers] <= 0 - one worker per hardware thread
+    explicit thread_pool_t(int num_workers = 0);
+    ~thread_pool_t();
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    thread_pool_t& operator=(const thread_pool_t&) = delete;
+
+    int get_num_workers() const {
+        return num_workers;
+    }
+
+    // Calls func(worker, task) for every task in [0, num_tasks), [worker] being
+    // index of worker in [0, get_num_workers()), which runs the task
+    // Blocks until all tasks are done. Tasks of range [grain] are never split
+    // If tasks throw, the rest of tasks are still run; exception of the task
+    // with the lowest index is rethrown
+    // Not reentrant: func must not call parallel_for of the same pool
+    void parallel_for(int num_tasks, const std::function<void(int, int)>& func, int grain = 1);
+
+private:
+    struct range_t {
+        int begin, end;
+    };
+
+    // Deque of ranges, owned by single worker, guarded by its own mutex
+    struct worker_t {
+        std::mutex lock;
+        std::deque<range_t> ranges;
+
+        bool pop_back(range_t& out);
+        bool steal_front(range_t& out);
+        void push_back(const range_t& range);
+    };
+
+    // mutexes and threads are not copyable, so that they are not kept in util::vector
+    int num_workers;
+    std::unique_ptr<worker_t[]> workers;
+    std::vector<std::thread> threads;
+
+    // Current loop, guarded by [lock]
+    std::mutex lock;
+    std::condition_variable wake;       /*new loop or shutdown*/
+    std::condition_variable finished;   /*all tasks are done and workers are idle*/
+    unsigned generation;
+    bool stop;
+    int active;                         /*workers inside current loop*/
+
+    const std::function<void(int, int)> *func;
+    int grain;
+    std::atomic<int> remaining;         /*tasks, which are not done*/
+    std::atomic<int> unclaimed;         /*tasks, which no worker has started to run*/
+
+    int error_task;                     /*lowest task, which threw, or -1*/
+    std::exception_ptr error;
+
+    void thread_main(int worker);
+
+    // Runs and steals ranges of current loop, until every task is taken by some worker
+    void work(int worker);
+
+    void run_range(int worker, range_t range);
+};
+
+} // namespace postfix::parallel
+
+#endif
@@ -7,6 +7,7 @@ token_t number(double num) {
     token_t token(
         tok_num,
         token_strategies::do_push_number_to_stack,
+        token_strategies::do_compile_number,
         token_strategies::do_push_itself_to_expr<token_number>,
         token_strategies::do_get_valid_prev_token<token_number>,
         token_strategies::do_influence_ctx_nothing<token_number>
@@ -15,12 +16,27 @@ token_t number(double num) {
     return token;
 }
 
+token_t variable(const std::string& name, std::uint32_t slot) {
+    token_variable tok_var(name, slot);
+    token_t token(
+        tok_var,
+        token_strategies::do_calc_throw<token_variable>, /*value is known only to bytecode evaluation*/
+        token_strategies::do_compile_variable,
+        token_strategies::do_push_itself_to_expr<token_variable>,
+        token_strategies::do_get_valid_prev_token<token_variable>,
+        token_strategies::do_influence_ctx_nothing<token_variable>
+    );
+
+    return token;
+}
+
 token_t left_parenthesis() {
     using left_par_t = token_left_parenthesis;
     left_par_t left_par;
     token_t token(
         left_par,
         token_strategies::do_calc_throw<left_par_t>,
+        token_strategies::do_compile_throw<left_par_t>,
         token_strategies::do_push_itself_to_stack<left_par_t>,
         token_strategies::do_get_valid_prev_token<left_par_t>,
         token_strategies::do_influence_ctx_apply<
@@ -38,6 +54,7 @@ token_t right_paranthesis() {
     token_t token(
         right_par,
         token_strategies::do_calc_throw<right_par_t>,
+        token_strategies::do_compile_throw<right_par_t>,
         token_strategies::do_push_all_including_left_paren<right_par_t>,
         token_strategies::do_get_valid_prev_token<right_par_t>,
         token_strategies::do_influence_ctx_apply<
@@ -55,6 +72,7 @@ token_t comma() {
     token_t token(
         com,
         token_strategies::do_calc_throw<comma_t>,
+        token_strategies::do_compile_throw<comma_t>,
         token_strategies::do_push_all_until_left_paren<comma_t>,
         token_strategies::do_get_valid_prev_token<comma_t>,
         token_strategies::do_influence_ctx_apply<
@@ -71,6 +89,7 @@ token_t plus() {
     token_t token(
         plus,
         token_strategies::do_calc_apply<token_plus, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<token_plus, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<token_plus>,
         token_strategies::do_get_valid_prev_token<token_plus>,
         token_strategies::do_influence_ctx_nothing<token_plus>
@@ -85,6 +104,7 @@ token_t plus_unary() {
     token_t token(
         plus_un,
         token_strategies::do_calc_apply<plus_un_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<plus_un_t, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<plus_un_t>,
         token_strategies::do_get_valid_prev_token<plus_un_t>,
         token_strategies::do_influence_ctx_nothing<plus_un_t>
@@ -99,6 +119,7 @@ token_t minus() {
     token_t token(
         minus,
         token_strategies::do_calc_apply<minus_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<minus_t, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<minus_t>,
         token_strategies::do_get_valid_prev_token<minus_t>,
         token_strategies::do_influence_ctx_nothing<minus_t>
@@ -113,6 +134,7 @@ token_t minus_unary() {
     token_t token(
         minus_un,
         token_strategies::do_calc_apply<minus_un_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<minus_un_t, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<minus_un_t>,
         token_strategies::do_get_valid_prev_token<minus_un_t>,
         token_strategies::do_influence_ctx_nothing<minus_un_t>
@@ -127,6 +149,7 @@ token_t multiplication() {
     token_t token(
         multi,
         token_strategies::do_calc_apply<multi_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<multi_t, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<multi_t>,
         token_strategies::do_get_valid_prev_token<multi_t>,
         token_strategies::do_influence_ctx_nothing<multi_t>
@@ -141,6 +164,7 @@ token_t division() {
     token_t token(
         division,
         token_strategies::do_calc_apply<div_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<div_t, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<div_t>,
         token_strategies::do_get_valid_prev_token<div_t>,
         token_strategies::do_influence_ctx_nothing<div_t>
@@ -155,6 +179,7 @@ token_t exp() {
     token_t token(
         exp,
         token_strategies::do_calc_apply<exp_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<exp_t, token_strategies::compile_token_funcs>,
         token_strategies::do_push_with_precedence<exp_t>,
         token_strategies::do_get_valid_prev_token<exp_t>,
         token_strategies::do_influence_ctx_apply<
@@ -165,4 +190,22 @@ token_t exp() {
 
     return token;
 }
+
+token_t fma() {
+    using fma_t = token_fma;
+    fma_t fma;
+    token_t token(
+        fma,
+        token_strategies::do_calc_apply<fma_t, token_strategies::calc_process_token_funcs>,
+        token_strategies::do_compile_apply<fma_t, token_strategies::compile_token_funcs>,
+        token_strategies::do_push_with_precedence<fma_t>,
+        token_strategies::do_get_valid_prev_token<fma_t>,
+        token_strategies::do_influence_ctx_apply<
+            fma_t,
+            token_strategies::influence_ctx_token_func_funcs
+        >
+    );
+
+    return token;
+}
 } // namespace postfix::builder
\ No newline at end of file
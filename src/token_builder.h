@@ -7,6 +7,7 @@
 namespace postfix::builder {
 
 token_t number(double num);
+token_t variable(const std::string& name, std::uint32_t slot);
 
 token_t left_parenthesis();
 token_t right_paranthesis();
@@ -20,6 +21,7 @@ token_t multiplication();
 token_t division();
 
 token_t exp();
+token_t fma();
 
 } // namespace postfix::builder
 
@@ -22,6 +22,7 @@ const std::string token_multiplication::name = "*";
 const std::string token_division::name = "/";
 
 const std::string token_exp::name = "exp";
+const std::string token_fma::name = "fma";
 
 
 /* Valid previous tokens */
@@ -36,6 +37,9 @@ const util::vector<precedence_t> token_number::valid_prev_tokens = {
     precedence_t::comma
 };
 
+// variable is placed as number
+const util::vector<precedence_t> token_variable::valid_prev_tokens = token_number::valid_prev_tokens;
+
 // Grammar
 const util::vector<precedence_t> token_left_parenthesis::valid_prev_tokens = {
     precedence_t::add_n_sub,
@@ -104,4 +108,13 @@ const util::vector<precedence_t> token_exp::valid_prev_tokens = {
     precedence_t::comma
 };
 
+const util::vector<precedence_t> token_fma::valid_prev_tokens = {
+    precedence_t::add_n_sub,
+    precedence_t::multiplication,
+    precedence_t::unary,
+
+    precedence_t::left_parenthesis,
+    precedence_t::comma
+};
+
 } // namespace postfix
\ No newline at end of file
@@ -38,6 +38,21 @@ public:
     static const util::vector<precedence_t> valid_prev_tokens;
 };
 
+// Named variable, resolved to slot index at conversion
+// Placed as number, its value is supplied at evaluation
+class token_variable {
+public:
+    std::string name;
+    std::uint32_t slot;
+
+    token_variable(const std::string& in_name = "", std::uint32_t in_slot = 0):
+        name(in_name), slot(in_slot) {}
+
+    static const precedence_t prec = precedence_t::number;
+    static const num_operands_t num_operands = 0;
+    static const util::vector<precedence_t> valid_prev_tokens;
+};
+
 
 /* Grammar */
 
@@ -126,6 +141,15 @@ public:
     static const util::vector<precedence_t> valid_prev_tokens;
 };
 
+// fma(x, y, z) = x * y + z, rounded once
+class token_fma {
+public:
+    static const std::string name;
+    static const precedence_t prec = precedence_t::function;
+    static const num_operands_t num_operands = 3;
+    static const util::vector<precedence_t> valid_prev_tokens;
+};
+
 
 /* Strategies */
 namespace token_strategies {
@@ -141,10 +165,10 @@ namespace token_strategies {
 
 template<typename tokenT>
 inline void do_push_all_until_left_paren(
-    tokenT& token,
+    tokenT& /*token*/,
     util::vector<token_t> &expr,
     util::stack<token_t> &st,
-    detail::token_concept_t *source_obj
+    detail::token_concept_t */*source_obj*/
 ) {
     // retrieve precedence (properties) of token_t
     while(!st.empty())
@@ -190,6 +214,31 @@ inline void do_push_number_to_stack(
 }
 
 
+
+/* compile_strategy template */
+// Callable
+// void func_name(
+//     tokenT& token,
+//     bytecode::program_t &prog
+// )
+
+// Number strategy
+inline void do_compile_number(
+    token_number& token,
+    bytecode::program_t &prog
+) {
+    prog.push_constant(token.number);
+}
+
+// Variable strategy
+inline void do_compile_variable(
+    token_variable& token,
+    bytecode::program_t &prog
+) {
+    prog.load_var(token.slot);
+}
+
+
 /* Functors */
 /* Used by Strategies */
 
@@ -199,57 +248,100 @@ public:
     /* General interface */
     // args are presented in original order
     // e.g. 1 + 2 -> args = {1, 2}
-    // double operator() (tokenT& token, util::vector<double> &args) {
+    // args hold exactly tokenT::num_operands values
+    // double operator() (tokenT& token, const double *args) {
 
 
     // token_plus function
-    double operator() (token_plus& token, util::vector<double>& args) {
+    double operator() (token_plus& /*token*/, const double *args) {
         return args[0] + args[1];
     }
 
     // token_plus_unary function
-    double operator() (token_plus_unary& token, util::vector<double>& args) {
+    double operator() (token_plus_unary& /*token*/, const double *args) {
         return args[0];
     }
 
     // token_minus function
-    double operator() (token_minus& token, util::vector<double>& args) {
+    double operator() (token_minus& /*token*/, const double *args) {
         return args[0] - args[1];
     }
 
     // token_minus_unary function
-    double operator() (token_minus_unary& token, util::vector<double>& args) {
+    double operator() (token_minus_unary& /*token*/, const double *args) {
         return -args[0];
     }
 
     // token_multiplication function
-    double operator() (token_multiplication& token, util::vector<double>& args) {
+    double operator() (token_multiplication& /*token*/, const double *args) {
         return args[0] * args[1];
     }
 
     // token_division function
-    double operator() (token_division& token, util::vector<double>& args) {
+    double operator() (token_division& /*token*/, const double *args) {
         return args[0] / args[1];
     }
 
     // token_exp function
-    double operator() (token_exp& token, util::vector<double>& args) {
+    double operator() (token_exp& /*token*/, const double *args) {
         return std::pow(args[0], args[1]);
     }
+
+    // token_fma function
+    double operator() (token_fma& /*token*/, const double *args) {
+        return std::fma(args[0], args[1], args[2]);
+    }
+};
+
+/* Set of opcodes, which implement functions of calc_process_token_funcs */
+class compile_token_funcs {
+public:
+    bytecode::opcode_t operator() (token_plus& /*token*/) {
+        return bytecode::opcode_t::add;
+    }
+
+    // unary plus does not change value
+    bytecode::opcode_t operator() (token_plus_unary& /*token*/) {
+        return bytecode::opcode_t::nop;
+    }
+
+    bytecode::opcode_t operator() (token_minus& /*token*/) {
+        return bytecode::opcode_t::sub;
+    }
+
+    bytecode::opcode_t operator() (token_minus_unary& /*token*/) {
+        return bytecode::opcode_t::neg;
+    }
+
+    bytecode::opcode_t operator() (token_multiplication& /*token*/) {
+        return bytecode::opcode_t::mul;
+    }
+
+    bytecode::opcode_t operator() (token_division& /*token*/) {
+        return bytecode::opcode_t::div;
+    }
+
+    bytecode::opcode_t operator() (token_exp& /*token*/) {
+        return bytecode::opcode_t::pow;
+    }
+
+    bytecode::opcode_t operator() (token_fma& /*token*/) {
+        return bytecode::opcode_t::fma;
+    }
 };
 
 class influence_ctx_token_grammar_funcs {
 public:
-    void operator() (token_left_parenthesis& token, token_conversion_ctx& ctx) {
+    void operator() (token_left_parenthesis& /*token*/, token_conversion_ctx& ctx) {
         ctx.parenthesis_commas.push(ctx.num_of_commas);
         ctx.num_of_commas = 0;
     }
 
-    void operator() (token_comma& token, token_conversion_ctx& ctx) {
+    void operator() (token_comma& /*token*/, token_conversion_ctx& ctx) {
         --ctx.parenthesis_commas.peek();
     }
 
-    void operator() (token_right_parenthesis& token, token_conversion_ctx& ctx) {
+    void operator() (token_right_parenthesis& /*token*/, token_conversion_ctx& ctx) {
         if(ctx.parenthesis_commas.size() == 0)
             throw std::logic_error("there is no corresponding left parenthesis");
 
@@ -8,6 +8,8 @@
 
 #include "util/unique_ptr.h"
 
+#include "bytecode.h"
+
 namespace postfix {
 
 typedef enum{
@@ -34,6 +36,9 @@ public:
     // calc_process
     virtual void calc_process(util::stack<double> &st) = 0;
 
+    // lower token into bytecode program
+    virtual void compile(bytecode::program_t &prog) = 0;
+
     // expr_push 
     virtual void expr_push(
         util::vector<token_t> &expr,
@@ -48,7 +53,7 @@ public:
     // get precedence of token
     virtual precedence_t get_precedence() const = 0;
 
-    virtual num_operands_t get_num_operands() = 0;
+    virtual num_operands_t get_num_operands() const = 0;
 
     virtual util::vector<precedence_t> get_valid_prev_token_prec() = 0;
 
@@ -69,6 +74,7 @@ public:
 template<
     typename tokenT,
     typename calc_process_strategy,
+    typename compile_strategy,
     typename expr_push_strategy,
     typename get_valid_prev_token_strategy,
     typename influence_context_strategy>
@@ -78,12 +84,14 @@ public:
     explicit owning_token_model_t(
         tokenT in_token,
         calc_process_strategy in_calc_strat,
+        compile_strategy in_compile_strat,
         expr_push_strategy in_expr_push_strat,
         get_valid_prev_token_strategy in_get_valid_strat,
         influence_context_strategy in_influence_ctx_strat
     ):
         m_token( in_token ),
         m_calc_strat( in_calc_strat ),
+        m_compile_strat( in_compile_strat ),
         m_expr_push_strat( in_expr_push_strat ),
         m_get_valid_prev_token_strat( in_get_valid_strat ),
         m_influence_ctx_strat( in_influence_ctx_strat )
@@ -93,6 +101,10 @@ public:
         m_calc_strat(m_token, st);
     }
 
+    void compile(bytecode::program_t &prog) {
+        m_compile_strat(m_token, prog);
+    }
+
     void expr_push(
         util::vector<token_t> &expr,
         util::stack<token_t> &st
@@ -115,7 +127,7 @@ public:
         return m_token.prec;
     }
 
-    num_operands_t get_num_operands() {
+    num_operands_t get_num_operands() const {
         // num of operands of m_token (which maybe an operator)
         return m_token.num_operands;
     }
@@ -132,6 +144,7 @@ private:
     tokenT m_token;
     /*Strategies*/
     calc_process_strategy m_calc_strat;
+    compile_strategy m_compile_strat;
     expr_push_strategy m_expr_push_strat;
     get_valid_prev_token_strategy m_get_valid_prev_token_strat;
     influence_context_strategy m_influence_ctx_strat;
@@ -148,6 +161,7 @@ public:
     template<
         typename tokenT,
         typename calc_process_strategy,
+        typename compile_strategy,
         typename expr_push_strategy,
         typename get_valid_prev_token_strategy,
         typename influence_context_strategy
@@ -155,6 +169,7 @@ public:
     token_t(
         tokenT token,
         calc_process_strategy calc_strat,
+        compile_strategy compile_strat,
         expr_push_strategy expr_strat,
         get_valid_prev_token_strategy valid_place_strat,
         influence_context_strategy influence_ctx_strat
@@ -163,12 +178,13 @@ public:
             detail::owning_token_model_t<
                 tokenT,
                 calc_process_strategy,
+                compile_strategy,
                 expr_push_strategy,
                 get_valid_prev_token_strategy,
                 influence_context_strategy
             >
         >( /*constructor*/
-            token, calc_strat, expr_strat,
+            token, calc_strat, compile_strat, expr_strat,
             valid_place_strat, influence_ctx_strat
         )
     ) {}
@@ -205,6 +221,10 @@ public:
         pimpl->calc_process(st);
     }
 
+    void compile(bytecode::program_t &prog) {
+        pimpl->compile(prog);
+    }
+
     // influence context of conversion of sequence of tokens
     void influence_ctx(token_conversion_ctx& ctx) {
         pimpl->influence_ctx(ctx);
@@ -226,6 +246,11 @@ public:
         return pimpl->get_precedence();
     }
 
+    // get number of operands, consumed by token in postfix expression
+    num_operands_t get_num_operands() const {
+        return pimpl->get_num_operands();
+    }
+
     bool is_valid_to_place_after(const token_t& before) {
         util::vector<precedence_t> valid_prev = get_valid_prev_token_prec();
         precedence_t prec = before.get_precedence();
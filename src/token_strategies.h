@@ -14,8 +14,8 @@ namespace postfix::token_strategies {
 
 template<typename tokenT>
 inline void do_push_itself_to_stack(
-    tokenT& token,
-    util::vector<token_t> &expr,
+    tokenT& /*token*/,
+    util::vector<token_t> &/*expr*/,
     util::stack<token_t> &st,
     detail::token_concept_t *source_obj
 ) {
@@ -25,9 +25,9 @@ inline void do_push_itself_to_stack(
 
 template<typename tokenT>
 inline void do_push_itself_to_expr(
-    tokenT& token,
+    tokenT& /*token*/,
     util::vector<token_t> &expr,
-    util::stack<token_t> &st,
+    util::stack<token_t> &/*st*/,
     detail::token_concept_t *source_obj
 ) {
     token_t token_obj(source_obj->clone());
@@ -59,7 +59,7 @@ inline void do_push_with_precedence(
 template<typename tokenT>
 inline void do_calc_throw(
     tokenT& token,
-    util::stack<double> &st
+    util::stack<double> &/*st*/
 ) {
     std::string err_msg = 
         "do_calc_throw: the token " +
@@ -83,8 +83,11 @@ inline void do_calc_apply(
         throw std::domain_error(err_msg);
     }
 
+    static_assert(tokenT::num_operands > 0, "do_calc_apply: operator must have operands");
+
     // Collect all arguments, in original order
-    util::vector<double> func_args(token.num_operands);
+    // Arity is known at compile time, thus no allocation is needed
+    double func_args[tokenT::num_operands];
     for(int i = token.num_operands - 1; i >= 0; --i) {
         func_args[i] = st.peek();
         st.pop();
@@ -94,6 +97,30 @@ inline void do_calc_apply(
     st.push(functor(token, func_args));
 }
 
+/* compile Strategies */
+
+template<typename tokenT>
+inline void do_compile_throw(
+    tokenT& token,
+    bytecode::program_t &/*prog*/
+) {
+    std::string err_msg = 
+        "do_compile_throw: the token " +
+        token.name +
+        " is not supposed to be in postfix expression to be compiled";
+    
+    throw std::logic_error(err_msg);
+}
+
+template<typename tokenT, typename OpcodeFunction>
+inline void do_compile_apply(
+    tokenT& token,
+    bytecode::program_t &prog
+) {
+    OpcodeFunction functor;
+    prog.apply(functor(token), token.num_operands, token.name);
+}
+
 /* get_valid_prev_token Strategies */
 
 template<typename tokenT>
@@ -104,7 +131,7 @@ util::vector<precedence_t> do_get_valid_prev_token(tokenT& token) {
 /* influence_context Strategies */
 
 template<typename tokenT>
-inline void do_influence_ctx_nothing(tokenT& token, token_conversion_ctx& ctx) {
+inline void do_influence_ctx_nothing(tokenT& /*token*/, token_conversion_ctx& /*ctx*/) {
     return; /*do nothing*/
 }
 
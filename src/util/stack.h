@@ -15,6 +15,8 @@ public:
     
     stack(std::initializer_list<T> list): c(list) {}
 
+    stack(const stack& other): c(other.c) {}
+
     bool
     operator==(const stack& other) const{
         return c == other.c;
@@ -58,6 +58,17 @@ public:
                 m_raw_ptr);
     }
 
+    // Constructor: take storage of [other], leaving it empty
+    vector(vector&& other) noexcept:
+        m_raw_ptr(other.m_raw_ptr),
+        m_size(other.m_size),
+        m_capacity(other.m_capacity)
+    {
+        other.m_raw_ptr = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+
     // Constructor: construct from initializer list
     vector(std::initializer_list<T> list):
         m_raw_ptr(
@@ -109,7 +120,7 @@ public:
         if(m_size != other.m_size)
             return false;
 
-        for(size_t i = 0; i < m_size; ++i)
+        for(size_type i = 0; i < m_size; ++i)
             if(m_raw_ptr[i] != other.m_raw_ptr[i])
                 return false;
         
@@ -155,7 +166,7 @@ public:
         return m_raw_ptr;
     }
 
-    const obj_ptr begin() const {
+    const_obj_ptr begin() const {
         return m_raw_ptr;
     }
     
@@ -163,7 +174,7 @@ public:
         return begin() + m_size;
     }
 
-    const obj_ptr end() const {
+    const_obj_ptr end() const {
         return begin() + m_size;
     }
 
@@ -0,0 +1,191 @@
+#include <catch2/catch_all.hpp>
+
+#include <cstdlib>
+#include <new>
+
+#include "postfix.h"
+
+// Replaced global allocation functions, counting number of allocations
+// Counting is enabled only inside of alloc_counter_t scope
+
+namespace {
+
+bool is_counting = false;
+long num_allocations = 0;
+
+class alloc_counter_t {
+public:
+    alloc_counter_t() {
+        num_allocations = 0;
+        is_counting = true;
+    }
+
+    ~alloc_counter_t() {
+        is_counting = false;
+    }
+
+    long get() const {
+        return num_allocations;
+    }
+};
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    if(is_counting)
+        ++num_allocations;
+
+    void *ptr = std::malloc(size ? size : 1);
+    if(ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+// GCC does not know, that replaced operator new allocates by malloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+namespace postfix {
+
+TEST_CASE("postfix_expr_t: evaluate does not allocate", "[postfix_expr_t][alloc]") {
+    postfix_converter_t converter;
+
+    // folded expression would be a single constant
+    compile_options_t options;
+    options.constant_folding = false;
+    converter.set_options(options);
+
+    postfix_expr_t expr = converter.convert("exp(2, 3) * (5 - (4 / (-(2 + 6)))) + 1.5");
+    REQUIRE(expr.get_program().get_code().size() > 1);
+    double res = expr.evaluate();
+
+    SECTION("preallocated scratch") {
+        alloc_counter_t counter;
+        for(int i = 0; i < 100; ++i)
+            REQUIRE(expr.evaluate() == res);
+
+        REQUIRE(counter.get() == 0);
+    }
+
+    SECTION("caller-supplied scratch") {
+        util::vector<double> scratch(expr.get_scratch_size());
+
+        alloc_counter_t counter;
+        for(int i = 0; i < 100; ++i)
+            REQUIRE(expr.evaluate(scratch.begin()) == res);
+
+        REQUIRE(counter.get() == 0);
+    }
+
+    SECTION("token evaluation in steady state") {
+        expr.evaluate_tokens(); // warm up value stack
+
+        alloc_counter_t counter;
+        for(int i = 0; i < 100; ++i)
+            REQUIRE(expr.evaluate_tokens() == res);
+
+        REQUIRE(counter.get() == 0);
+    }
+}
+
+TEST_CASE("postfix_expr_t: batch evaluation allocates only once", "[postfix_expr_t][alloc]") {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+    postfix_expr_t expr = converter.convert("x * 2 + 1");
+
+    const int num_rows = 100;
+    util::vector<double> x(num_rows, 1.5), results(num_rows);
+    const double *columns[] = { x.begin() };
+
+    // the first call builds batch form of program
+    expr.evaluate_batch(columns, num_rows, results.begin());
+
+    alloc_counter_t counter;
+    for(int i = 0; i < 10; ++i)
+        expr.evaluate_batch(columns, num_rows, results.begin());
+
+    REQUIRE(counter.get() == 0);
+    REQUIRE(results[num_rows - 1] == 4);
+}
+
+TEST_CASE("postfix_expr_t: parallel evaluation allocates only once", "[postfix_expr_t][alloc]") {
+    postfix_converter_t converter;
+    compile_options_t options;
+    options.constant_folding = false;
+    options.parallel_task_size = 4;
+    converter.set_options(options);
+    converter.add_variable("x");
+
+    postfix_expr_t expr = converter.convert("(x + 1) * (x + 2) - (x + 3) * (x + 4)");
+    double x = 1.5;
+    double res = expr.evaluate_at(&x);
+
+    // pool and expression are warmed up by the first call, which splits program
+    parallel::thread_pool_t pool(3);
+    REQUIRE(expr.evaluate_parallel(pool, &x) == res);
+
+    alloc_counter_t counter;
+    for(int i = 0; i < 10; ++i)
+        REQUIRE(expr.evaluate_parallel(pool, &x) == res);
+
+    REQUIRE(counter.get() == 0);
+}
+
+TEST_CASE("operator_trie_t: lookup does not allocate", "[operator_trie_t][alloc]") {
+    util::vector<std::string> names = { "(", ")", "+", "+", ",", "-", "-", "exp", "expm1", "fma" };
+    detail::operator_trie_t trie(names);
+
+    const char in_str[] = "fma(expm1,+exp,-)";
+    const char *end = in_str + sizeof(in_str) - 1;
+
+    // only tokens, built from found factories, are allocated by to_operator
+    alloc_counter_t counter;
+    int num_names = 0, num_matches = 0;
+    for(const char *iter = in_str; iter != end; ++num_names) {
+        int first, last;
+        iter = trie.match(iter, end, first, last);
+        num_matches += last - first;
+    }
+    long allocations = counter.get();
+
+    REQUIRE(num_names == 9);
+    REQUIRE(num_matches == 11);
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("bytecode: stack depth and arity are computed at convert time", "[bytecode][alloc]") {
+    postfix_converter_t converter;
+    postfix_expr_t expr;
+
+    // keep program as it is lowered from tokens
+    compile_options_t options;
+    options.constant_folding = false;
+    options.superinstructions = bytecode::superinstruction_set_t::none();
+    options.scheduling = false;
+    converter.set_options(options);
+
+    expr = converter.convert("1");
+    REQUIRE(expr.get_program().get_max_depth() == 1);
+    REQUIRE(expr.get_program().get_max_num_operands() == 0);
+
+    expr = converter.convert("1 + 2 * 3");
+    REQUIRE(expr.get_program().get_max_depth() == 3);
+    REQUIRE(expr.get_program().get_max_num_operands() == 2);
+
+    expr = converter.convert("-1");
+    REQUIRE(expr.get_program().get_max_num_operands() == 1);
+}
+
+} // namespace postfix
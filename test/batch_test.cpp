@@ -0,0 +1,251 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "batch.h"
+
+#include "expr_generator.h"
+
+#include <cstddef>
+#include <random>
+
+namespace postfix::simd {
+
+namespace {
+
+const isa_t isas[] = { isa_t::scalar, isa_t::sse2, isa_t::avx2, isa_t::avx512 };
+
+const backend_t backends[] = {
+    backend_t::switch_dispatch,
+    backend_t::threaded,
+    backend_t::register_vm,
+    backend_t::jit,
+    backend_t::slp
+};
+
+postfix_converter_t make_converter() {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    converter.add_variable("x");
+    converter.add_variable("y");
+    converter.add_variable("z");
+
+    return converter;
+}
+
+// Columns of [num_vars] variables with random values
+util::vector< util::vector<double> > random_columns(int num_vars, int num_rows, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(-10, 10);
+
+    util::vector< util::vector<double> > columns(num_vars);
+    for(int v = 0; v < num_vars; ++v)
+        for(int r = 0; r < num_rows; ++r)
+            columns[v].push_back(dist(rng));
+
+    return columns;
+}
+
+} // namespace
+
+TEST_CASE("batch: variables", "[batch][normal]") {
+    postfix_converter_t converter;
+
+    SECTION("slots are given in order of declaration") {
+        REQUIRE(converter.add_variable("x") == 0);
+        REQUIRE(converter.add_variable("rate_2") == 1);
+        REQUIRE(converter.get_variables().size() == 2);
+    }
+
+    SECTION("invalid names") {
+        converter.add_variable("x");
+        REQUIRE_THROWS_AS(converter.add_variable("x"), std::invalid_argument);
+        REQUIRE_THROWS_AS(converter.add_variable("exp"), std::invalid_argument);
+        REQUIRE_THROWS_AS(converter.add_variable("1x"), std::invalid_argument);
+        REQUIRE_THROWS_AS(converter.add_variable(""), std::invalid_argument);
+    }
+
+    SECTION("evaluate_at") {
+        converter.add_variable("x");
+        converter.add_variable("y");
+
+        postfix_expr_t expr = converter.convert("x * x + y");
+        REQUIRE(expr.get_num_variables() == 2);
+
+        double values[] = { 3, 0.5 };
+        REQUIRE(expr.evaluate_at(values) == 9.5);
+
+        // variables are not folded into constants
+        values[0] = -2;
+        REQUIRE(expr.evaluate_at(values) == 4.5);
+    }
+
+    SECTION("variable, whose name starts with name of function") {
+        converter.add_variable("expo");
+        postfix_expr_t expr = converter.convert("exp(expo, 2)");
+
+        double value = 3;
+        REQUIRE(expr.evaluate_at(&value) == 9);
+    }
+
+    SECTION("undeclared name is an error") {
+        converter.add_variable("x");
+        REQUIRE_THROWS(converter.convert("x + y"));
+    }
+
+    SECTION("expression with variables requires their values") {
+        converter.add_variable("x");
+        postfix_expr_t expr = converter.convert("x + 1");
+
+        REQUIRE_THROWS_AS(expr.evaluate(), std::logic_error);
+        REQUIRE_THROWS(expr.evaluate_tokens());
+    }
+}
+
+TEST_CASE("batch: evaluate_at on every backend", "[batch][normal]") {
+    postfix_converter_t converter = make_converter();
+    postfix_expr_t expr = converter.convert("(x * 2 + y * 3) * (z - x) / exp(y, 2) + fma(x, y, z)");
+
+    double values[] = { 1.5, -2, 4 };
+    double expected = (1.5 * 2 + -2 * 3) * (4 - 1.5) / 4 + std::fma(1.5, -2, 4);
+
+    for(backend_t backend : backends) {
+        expr.set_backend(backend);
+        REQUIRE(expr.evaluate_at(values) == expected);
+    }
+}
+
+TEST_CASE("batch: evaluate_batch", "[batch][normal]") {
+    postfix_converter_t converter = make_converter();
+
+    SECTION("rows are independent") {
+        postfix_expr_t expr = converter.convert("x * y - z");
+
+        double x[] = { 1, 2, 3 }, y[] = { 4, 5, 6 }, z[] = { 0.5, 0.25, 0.125 };
+        const double *columns[] = { x, y, z };
+        double results[3];
+
+        expr.evaluate_batch(columns, 3, results);
+        REQUIRE(results[0] == 3.5);
+        REQUIRE(results[1] == 9.75);
+        REQUIRE(results[2] == 17.875);
+    }
+
+    SECTION("invalid expression") {
+        postfix_expr_t expr = converter.convert("x + ()");
+        double x = 1;
+        const double *columns[] = { &x, &x, &x };
+        REQUIRE_THROWS(expr.evaluate_batch(columns, 1, &x));
+    }
+}
+
+TEST_CASE("batch: differential test against evaluate_at", "[batch][differential]") {
+    postfix_converter_t converter = make_converter();
+    test::expr_generator_t gen(1414);
+
+    // not a multiple of block_rows: last block is partial
+    const int num_rows = 1000;
+    util::vector< util::vector<double> > values = random_columns(3, num_rows, 7);
+    const double *columns[] = { values[0].begin(), values[1].begin(), values[2].begin() };
+    util::vector<double> results(num_rows);
+
+    for(int i = 0; i < 100; ++i) {
+        std::string in = "(" + gen.generate(4) + ") * x + exp(y, 2) / (" + gen.generate(4) + ") - z * y";
+        postfix_expr_t expr = converter.convert(in);
+
+        util::vector<double> expected;
+        for(int r = 0; r < num_rows; ++r) {
+            double row[] = { columns[0][r], columns[1][r], columns[2][r] };
+            expected.push_back(expr.evaluate_at(row));
+        }
+
+        INFO(in);
+        for(isa_t isa : isas) {
+            if(!isa_supported(isa))
+                continue;
+
+            batch_program_t batch(expr.get_program(), isa);
+            util::vector<double> scratch(batch.get_scratch_size());
+            batch.run(columns, num_rows, results.begin(), scratch.begin());
+
+            INFO(isa_name(isa));
+            for(int r = 0; r < num_rows; ++r)
+                REQUIRE(test::same_value(results[r], expected[r]));
+        }
+    }
+}
+
+TEST_CASE("batch: strided bindings", "[batch][normal]") {
+    struct quote_t {
+        double bid, ask;
+        int qty;
+        double weight;
+    };
+
+    postfix_converter_t converter;
+    converter.add_variable("bid");
+    converter.add_variable("ask");
+    converter.add_variable("weight");
+    postfix_expr_t expr = converter.convert("(ask - bid) * weight + bid / 2");
+
+    // spans several blocks, last one is partial
+    const int num_rows = 200;
+    util::vector<quote_t> quotes;
+    for(int r = 0; r < num_rows; ++r) {
+        quote_t quote = { 100 + r * 0.5, 101 + r * 0.75, r, 1.0 / (r + 1) };
+        quotes.push_back(quote);
+    }
+
+    util::vector<double> expected;
+    for(int r = 0; r < num_rows; ++r) {
+        double row[] = { quotes[r].bid, quotes[r].ask, quotes[r].weight };
+        expected.push_back(expr.evaluate_at(row));
+    }
+
+    SECTION("fields of array of structs") {
+        binding_t bindings[] = {
+            binding_t::field(quotes.begin(), &quote_t::bid),
+            binding_t::field(quotes.begin(), &quote_t::ask),
+            binding_t::field(quotes.begin(), &quote_t::weight)
+        };
+        REQUIRE(bindings[2].offset == offsetof(quote_t, weight));
+        REQUIRE(bindings[2].stride == sizeof(quote_t));
+
+        for(isa_t isa : isas) {
+            if(!isa_supported(isa))
+                continue;
+
+            batch_program_t batch(expr.get_program(), isa);
+            util::vector<double> scratch(batch.get_scratch_size());
+            util::vector<double> results(num_rows);
+            batch.run(bindings, num_rows, results.begin(), scratch.begin());
+
+            INFO(isa_name(isa));
+            REQUIRE(results == expected);
+        }
+    }
+
+    SECTION("mixed with contiguous column and reversed order") {
+        util::vector<double> weights;
+        for(int r = num_rows - 1; r >= 0; --r)
+            weights.push_back(quotes[r].weight);
+
+        binding_t bindings[] = {
+            binding_t::field(quotes.begin(), &quote_t::bid),
+            binding_t::field(quotes.begin(), &quote_t::ask),
+            { weights.end() - 1, 0, -(std::ptrdiff_t) sizeof(double) }
+        };
+
+        util::vector<double> results(num_rows);
+        expr.evaluate_batch(bindings, num_rows, results.begin());
+        REQUIRE(results == expected);
+
+        // weights in reverse order of quotes
+        bindings[2] = binding_t::column(weights.begin());
+        expr.evaluate_batch(bindings, num_rows, results.begin());
+        for(int r = 0; r < num_rows; ++r) {
+            double row[] = { quotes[r].bid, quotes[r].ask, weights[r] };
+            REQUIRE(results[r] == expr.evaluate_at(row));
+        }
+    }
+}
+
+} // namespace postfix::simd
@@ -0,0 +1,182 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "bytecode.h"
+
+#include "expr_generator.h"
+
+namespace postfix::bytecode {
+
+TEST_CASE("bytecode: program emission", "[bytecode][normal]") {
+    program_t prog;
+
+    // 2 * (3 + 4) -> 2 3 4 + *
+    prog.push_constant(2);
+    prog.push_constant(3);
+    prog.push_constant(4);
+    prog.apply(opcode_t::add, 2, "+");
+    prog.apply(opcode_t::mul, 2, "*");
+
+    REQUIRE(prog.get_code().size() == 5);
+    REQUIRE(prog.get_constants().size() == 3);
+    REQUIRE(prog.get_max_depth() == 3);
+    REQUIRE_NOTHROW(prog.check());
+
+    double stack[3];
+    REQUIRE(interpret(prog, stack) == 14);
+}
+
+TEST_CASE("bytecode: identity operator emits no code", "[bytecode][normal]") {
+    program_t prog;
+
+    prog.push_constant(5);
+    prog.apply(opcode_t::nop, 1, "+");
+
+    REQUIRE(prog.get_code().size() == 1);
+    REQUIRE_NOTHROW(prog.check());
+}
+
+TEST_CASE("bytecode: invalid programs", "[bytecode][error]") {
+    program_t prog;
+
+    SECTION("not enough operands") {
+        prog.push_constant(5);
+        prog.apply(opcode_t::add, 2, "+");
+
+        REQUIRE_THROWS_AS(prog.check(), std::domain_error);
+    }
+
+    SECTION("too much values left") {
+        prog.push_constant(5);
+        prog.push_constant(5);
+
+        REQUIRE_THROWS_AS(prog.check(), std::logic_error);
+    }
+
+    SECTION("empty program") {
+        REQUIRE_THROWS_AS(prog.check(), std::logic_error);
+    }
+}
+
+TEST_CASE("bytecode: compiled expression matches token evaluation", "[bytecode][postfix_expr_t]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    postfix_expr_t expr;
+
+    const char *inputs[] = {
+        "1 + 2",
+        "10 + (5 - 10) - (3 - 5)",
+        "(5 * 3 / 2) * (3 + 0 - 5)",
+        "-5 * (-3 - 5)",
+        "-(+123)",
+        "+exp(2,-1)",
+        "exp(exp(2, 2), 0.5) / 3 - 7 * (1.5 - 0.25)"
+    };
+
+    for(const char *in : inputs) {
+        expr = converter.convert(in);
+        REQUIRE(expr.evaluate() == expr.evaluate_tokens());
+    }
+}
+
+TEST_CASE("bytecode: threaded backend matches switch backend", "[bytecode][postfix_expr_t]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    postfix_expr_t expr;
+
+    const char *inputs[] = {
+        "1",
+        "-(-123 + 21)",
+        "( (-5)*3 + (4 * (-3)) )",
+        "exp(2, 0.5) * (7 / 3) - exp(-(3), 3)"
+    };
+
+    for(const char *in : inputs) {
+        expr = converter.convert(in);
+        double expected = expr.evaluate();
+
+        expr.set_backend(backend_t::threaded);
+        REQUIRE(expr.get_backend() == backend_t::threaded);
+        REQUIRE(expr.evaluate() == expected);
+
+        // copy keeps selected backend
+        postfix_expr_t copy = expr;
+        REQUIRE(copy.evaluate() == expected);
+
+        expr.set_backend(backend_t::switch_dispatch);
+        REQUIRE(expr.evaluate() == expected);
+    }
+}
+
+TEST_CASE("bytecode: errors are reported on evaluation", "[bytecode][postfix_expr_t]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    postfix_expr_t expr;
+
+    // empty expression is converted, but can not be evaluated
+    REQUIRE_NOTHROW(expr = converter.convert("()"));
+    REQUIRE_THROWS_AS(expr.evaluate(), std::logic_error);
+
+    // function with empty argument
+    REQUIRE_NOTHROW(expr = converter.convert("exp((), 2)"));
+    REQUIRE_THROWS_AS(expr.evaluate(), std::domain_error);
+    REQUIRE_THROWS_AS(expr.evaluate_tokens(), std::domain_error);
+
+    expr.set_backend(backend_t::threaded);
+    REQUIRE_THROWS_AS(expr.evaluate(), std::domain_error);
+}
+
+TEST_CASE("bytecode: program set", "[bytecode][program_set]") {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+    program_set_t set;
+
+    SECTION("programs are packed one after another") {
+        REQUIRE(set.add(converter.convert("1 + 2 * x").get_program()) == 0);
+        REQUIRE(set.add(converter.convert("exp(x, 0.5) - 10").get_program()) == 1);
+        REQUIRE(set.add(converter.convert("42").get_program()) == 2);
+        REQUIRE(set.size() == 3);
+
+        // constants of later programs are rebased into shared pool
+        REQUIRE(set.get_constants().size() == converter.convert("1 + 2 * x").get_program().get_constants().size() + 2);
+        REQUIRE(set.get_code()[set.get_code().size() - 1].op == opcode_t::halt);
+
+        double x = 4;
+        double results[3];
+        set.evaluate_all(results, &x);
+        REQUIRE(results[0] == 9);
+        REQUIRE(results[1] == -8);
+        REQUIRE(results[2] == 42);
+
+        REQUIRE(set.evaluate(1, &x) == -8);
+        REQUIRE(set.evaluate(2, &x) == 42);
+    }
+
+    SECTION("errors") {
+        REQUIRE_THROWS(set.add(converter.convert("exp((), 2)").get_program()));
+        REQUIRE(set.size() == 0);
+
+        set.add(converter.convert("x").get_program());
+        double result;
+        REQUIRE_THROWS_AS(set.evaluate_all(&result), std::logic_error);
+    }
+}
+
+TEST_CASE("bytecode: program set matches separate programs", "[bytecode][program_set]") {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+    test::expr_generator_t gen(1717);
+
+    util::vector<postfix_expr_t> exprs;
+    program_set_t set;
+    for(int i = 0; i < 2000; ++i) {
+        exprs.push_back(converter.convert(gen.generate(6) + " * x"));
+        set.add(exprs[i].get_program());
+    }
+
+    double x = -1.25;
+    util::vector<double> results(exprs.size());
+    set.evaluate_all(results.begin(), &x);
+
+    for(int i = 0; i < exprs.size(); ++i)
+        REQUIRE(test::same_value(results[i], exprs[i].evaluate_at(&x)));
+}
+
+} // namespace postfix::bytecode
@@ -0,0 +1,126 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "expr_dag.h"
+
+#include "expr_generator.h"
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+} // namespace
+
+TEST_CASE("expr_dag: hash-consing", "[expr_dag][normal]") {
+    expr_dag_t dag;
+
+    int two = dag.make_const(2);
+    REQUIRE(dag.make_const(2) == two);
+    REQUIRE(dag.make_const(-0.0) != dag.make_const(0.0));
+
+    int sum = dag.make_binary(op_t::add, two, dag.make_const(3));
+    REQUIRE(dag.make_binary(op_t::add, two, dag.make_const(3)) == sum);
+    REQUIRE(dag.make_binary(op_t::add, dag.make_const(3), two) != sum);
+    REQUIRE(dag.size() == 6);
+
+    expr_dag_t tree(false);
+    REQUIRE(tree.make_const(2) != tree.make_const(2));
+}
+
+TEST_CASE("expr_dag: common subexpressions are evaluated once", "[expr_dag][normal]") {
+    const char *in = "(2*3+1)*(2*3+1)+(2*3+1)";
+
+    postfix_expr_t plain = test::make_plain_converter(&compile_options_t::common_subexpressions, false)
+        .convert(in);
+    postfix_expr_t expr = test::make_plain_converter(&compile_options_t::common_subexpressions, true)
+        .convert(in);
+
+    const bytecode::program_t& prog = expr.get_program();
+    REQUIRE(prog.get_code().size() < plain.get_program().get_code().size());
+    REQUIRE(test::count_ops(prog, op_t::mul) == 2);
+    REQUIRE(test::count_ops(prog, op_t::dup) == 1);
+    REQUIRE(test::count_ops(prog, op_t::store_tmp) == 1);
+    REQUIRE(test::count_ops(prog, op_t::load_tmp) == 1);
+    REQUIRE(prog.get_num_temps() == 1);
+    REQUIRE(expr.get_scratch_size() == prog.get_max_depth() + 1);
+
+    REQUIRE(expr.evaluate() == 56);
+    REQUIRE(expr.evaluate_tokens() == 56);
+
+    SECTION("is on by default") {
+        REQUIRE(postfix_converter_t().get_options().common_subexpressions);
+    }
+
+    SECTION("constants are not shared") {
+        expr = test::make_plain_converter(&compile_options_t::common_subexpressions, true)
+            .convert("2 + 2 * 2");
+        REQUIRE(expr.get_program().get_num_temps() == 0);
+        REQUIRE(expr.evaluate() == 6);
+    }
+}
+
+TEST_CASE("expr_dag: round trip of program", "[expr_dag][normal]") {
+    postfix_expr_t expr = test::make_plain_converter(&compile_options_t::common_subexpressions, false)
+        .convert("-(1 - 2) / exp(1 - 2, 2)");
+
+    expr_dag_t dag;
+    REQUIRE(expr_dag_t::from_program(expr.get_program(), true, dag));
+    // 1, 2, 1 - 2, neg, exp, / (2 appears twice, but is single node)
+    REQUIRE(dag.size() == 6);
+
+    bytecode::program_t prog = dag.to_program();
+    REQUIRE(prog.valid());
+    util::vector<double> scratch(prog.get_scratch_size());
+    REQUIRE(bytecode::interpret(prog, scratch.begin()) == 1);
+
+    // invalid program is not represented
+    bytecode::program_t invalid;
+    invalid.push_constant(1);
+    invalid.apply(op_t::add, 2, "+");
+    REQUIRE_FALSE(expr_dag_t::from_program(invalid, true, dag));
+}
+
+TEST_CASE("expr_dag: deep expression", "[expr_dag][normal]") {
+    // two copies of ((((1 * 1) * 1) ... * 1), each is deep
+    std::string in(20000, '(');
+    in += "1";
+    for(int i = 0; i < 20000; ++i)
+        in += " * 1)";
+    in = in + " - 2 * " + in;
+
+    postfix_expr_t expr = test::make_plain_converter(&compile_options_t::common_subexpressions, true)
+        .convert(in);
+    REQUIRE(test::count_ops(expr.get_program(), op_t::load_tmp) == 1);
+    REQUIRE(expr.evaluate() == -1);
+}
+
+TEST_CASE("expr_dag: differential test against program without CSE", "[expr_dag][differential]") {
+    postfix_converter_t plain_converter =
+        test::make_plain_converter(&compile_options_t::common_subexpressions, false);
+    postfix_converter_t converter = test::make_unfolded_converter();
+    test::expr_generator_t gen(808);
+
+    const backend_t backends[] = {
+        backend_t::switch_dispatch,
+        backend_t::threaded,
+        backend_t::register_vm,
+        backend_t::jit
+    };
+
+    for(int i = 0; i < 500; ++i) {
+        std::string in = gen.generate(6);
+        postfix_expr_t plain = plain_converter.convert(in);
+        postfix_expr_t expr = converter.convert(in);
+        double expected = plain.evaluate();
+
+        INFO(in);
+        for(backend_t backend : backends) {
+            expr.set_backend(backend);
+            REQUIRE(test::same_value(expr.evaluate(), expected));
+        }
+    }
+}
+
+} // namespace postfix::optimizer
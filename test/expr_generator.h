@@ -0,0 +1,102 @@
+#ifndef EXPR_GENERATOR_H
+#define EXPR_GENERATOR_H
+
+/**
+ * Random infix expressions for differential tests
+*/
+
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "postfix.h"
+
+namespace postfix::test {
+
+class expr_generator_t {
+public:
+    explicit expr_generator_t(unsigned seed): rng(seed) {}
+
+    // Random syntactically valid expression with nesting up to [max_depth]
+    std::string generate(int max_depth) {
+        int kind = max_depth <= 0 ? 0 : pick(7);
+
+        switch(kind) {
+        case 0:
+            return number();
+        case 1: /*unary operators can follow only left parenthesis or comma*/
+            return std::string("(") + (pick(2) ? "-" : "+") + generate(max_depth - 1) + ")";
+        case 2: /*small exponent keeps values finite*/
+            return "exp(" + generate(max_depth - 1) + ", " + std::to_string(pick(4)) + ")";
+        default:
+            return "(" + generate(max_depth - 1) + binary_op() + generate(max_depth - 1) + ")";
+        }
+    }
+
+private:
+    std::mt19937 rng;
+
+    int pick(int n) {
+        return std::uniform_int_distribution<int>(0, n - 1)(rng);
+    }
+
+    std::string number() {
+        static const char *numbers[] = { "1", "2", "3", "0.5", "7", "12.25", "0.1", "100" };
+        return numbers[pick(8)];
+    }
+
+    std::string binary_op() {
+        static const char *ops[] = { " + ", " - ", " * ", " / " };
+        return ops[pick(4)];
+    }
+};
+
+// Converter, which keeps constant expressions as they are,
+// so that backends execute whole program
+inline postfix_converter_t make_unfolded_converter() {
+    postfix_converter_t converter;
+    compile_options_t options;
+    options.constant_folding = false;
+    converter.set_options(options);
+
+    return converter;
+}
+
+// Options, under which program mirrors expression: operands are not folded,
+// so that they stand for unknown values; superinstructions are off,
+// so that program shows basic operators
+inline compile_options_t plain_options() {
+    compile_options_t options;
+    options.constant_folding = false;
+    options.superinstructions = bytecode::superinstruction_set_t::none();
+
+    return options;
+}
+
+// Converter with plain_options(), where option [flag] is set to [value]
+inline postfix_converter_t make_plain_converter(bool compile_options_t::*flag, bool value) {
+    compile_options_t options = plain_options();
+    options.*flag = value;
+
+    postfix_converter_t converter;
+    converter.set_options(options);
+
+    return converter;
+}
+
+// Number of [op] instructions in [prog]
+inline int count_ops(const bytecode::program_t& prog, bytecode::opcode_t op) {
+    int num = 0;
+    for(int i = 0; i < prog.get_code().size(); ++i)
+        num += prog.get_code()[i].op == op;
+    return num;
+}
+
+// Equality, which treats NaN as equal to NaN
+inline bool same_value(double a, double b) {
+    return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+} // namespace postfix::test
+
+#endif
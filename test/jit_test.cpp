@@ -0,0 +1,90 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "jit.h"
+
+#include "expr_generator.h"
+
+namespace postfix::jit {
+
+TEST_CASE("jit: code emission", "[jit][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    util::vector<std::uint8_t> code;
+
+    SECTION("valid program is emitted") {
+        postfix_expr_t expr = converter.convert("exp(2, 3) * (1 - 4 / 2)");
+        REQUIRE(jit_program_t::emit(expr.get_program(), code));
+        REQUIRE_FALSE(code.empty());
+        REQUIRE(code[code.size() - 1] == 0xC3); // ret
+    }
+
+    SECTION("invalid program is not emitted") {
+        postfix_expr_t expr = converter.convert("exp((), 2)");
+        REQUIRE_FALSE(jit_program_t::emit(expr.get_program(), code));
+    }
+}
+
+#if POSTFIX_HAS_JIT
+
+TEST_CASE("jit: compiled expressions", "[jit][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    postfix_expr_t expr;
+
+    const char *inputs[] = {
+        "5",
+        "-5",
+        "1 + 2",
+        "3 - 5",
+        "-(-123 + 21)",
+        "(5 * 3 / 2) * (3 + 0 - 5)",
+        "exp(2, 3)",
+        "+exp(2, -1)",
+        "exp(exp(2, 0.5), 2 + 1) - 1 * 3",
+        "1 - 2 * 3 + 4 * 5"
+    };
+
+    for(const char *in : inputs) {
+        expr = converter.convert(in);
+        double expected = expr.evaluate();
+
+        expr.set_backend(backend_t::jit);
+        jit_program_t native(expr.get_program());
+        REQUIRE(native.compiled());
+
+        INFO(in);
+        REQUIRE(expr.evaluate() == expected);
+
+        // copies share executable memory
+        postfix_expr_t copy = expr;
+        REQUIRE(copy.evaluate() == expected);
+    }
+}
+
+TEST_CASE("jit: differential test against stack machine", "[jit][differential]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    test::expr_generator_t gen(1234);
+
+    for(int i = 0; i < 500; ++i) {
+        std::string in = gen.generate(7);
+        postfix_expr_t expr = converter.convert(in);
+
+        double expected = expr.evaluate();
+        expr.set_backend(backend_t::jit);
+
+        INFO(in);
+        REQUIRE(test::same_value(expr.evaluate(), expected));
+    }
+}
+
+#endif
+
+TEST_CASE("jit: backend falls back to interpreter", "[jit][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    postfix_expr_t expr = converter.convert("exp((), 2)");
+
+    // invalid program is not compiled, interpreter reports error
+    expr.set_backend(backend_t::jit);
+    REQUIRE_THROWS_AS(expr.evaluate(), std::domain_error);
+}
+
+} // namespace postfix::jit
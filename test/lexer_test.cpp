@@ -0,0 +1,76 @@
+#include <catch2/catch_all.hpp>
+
+#include "lexer.h"
+#include "postfix.h"
+
+#include <cctype>
+#include <random>
+#include <string>
+
+namespace postfix::lexer {
+
+namespace {
+
+// characters, which are interesting to classification, and a few others
+const char alphabet[] = " \t\n\v\f\r0189.()*+,-/azAZ_@[`{\x7f\x80\xff$";
+
+} // namespace
+
+TEST_CASE("lexer: classes of characters", "[lexer][normal]") {
+    // table is as of C locale, which is the default one
+    for(int c = 0; c < 256; ++c) {
+        INFO(c);
+        unsigned classes = classes_of((char) c);
+        REQUIRE(bool(classes & space) == bool(std::isspace(c)));
+        REQUIRE(bool(classes & digit) == bool(std::isdigit(c)));
+        REQUIRE(bool(classes & identifier) == bool(std::isalnum(c) || c == '_'));
+    }
+
+    REQUIRE(classes_of('.') == dot);
+    REQUIRE(classes_of('-') == operator_);
+    REQUIRE(classes_of('(') == operator_);
+    REQUIRE(classes_of('$') == 0);
+}
+
+TEST_CASE("lexer: vector scans match scalar one", "[lexer][normal]") {
+    const simd::isa_t isas[] = { simd::isa_t::sse2, simd::isa_t::avx2, simd::isa_t::avx512 };
+    const unsigned class_sets[] = { space, digit, dot, operator_, identifier, space | digit, digit | dot, ~0u };
+    std::mt19937 rng(2222);
+
+    for(int iter = 0; iter < 2000; ++iter) {
+        // long runs of one class, broken by single character of any class
+        unsigned classes = class_sets[iter % 8];
+        std::string in;
+        int len = rng() % 100;
+        for(int i = 0; i < len; ++i) {
+            char c = alphabet[rng() % (sizeof(alphabet) - 1)];
+            while(rng() % 8 != 0 && !(classes_of(c) & classes))
+                c = alphabet[rng() % (sizeof(alphabet) - 1)];
+            in += c;
+        }
+
+        const char *beg = in.data(), *end = in.data() + in.size();
+        const char *expected = skip(beg, end, classes, simd::isa_t::scalar);
+
+        INFO(in);
+        INFO(classes);
+        REQUIRE(skip(beg, end, classes) == expected);
+        for(simd::isa_t isa : isas)
+            if(simd::isa_supported(isa))
+                REQUIRE(skip(beg, end, classes, isa) == expected);
+    }
+}
+
+TEST_CASE("lexer: padded input and long literals", "[lexer][normal]") {
+    postfix_converter_t converter;
+
+    std::string padding(1000, ' ');
+    padding[500] = '\t';
+    padding[700] = '\n';
+
+    std::string digits = std::string(40, '0') + "12";
+    std::string in = padding + digits + ".5" + std::string(30, '0') + padding + "+" + padding + "1" + padding;
+    REQUIRE(converter.convert(in).evaluate() == 13.5);
+}
+
+} // namespace postfix::lexer
@@ -0,0 +1,155 @@
+#include <catch2/catch_all.hpp>
+
+#include "number_parser.h"
+#include "postfix.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+namespace postfix::lexer {
+
+namespace {
+
+std::uint64_t bits_of(double val) {
+    std::uint64_t res;
+    std::memcpy(&res, &val, sizeof(res));
+    return res;
+}
+
+// [in] is parsed as whole and exactly as by strtod
+void require_as_strtod(const std::string& in) {
+    const char *beg = in.data(), *end = in.data() + in.size();
+    double val = -1;
+
+    INFO(in);
+    REQUIRE(parse_number(beg, end, val) == end);
+    REQUIRE(bits_of(val) == bits_of(std::strtod(in.c_str(), NULL)));
+}
+
+std::string printed(const char *format, double val) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), format, val);
+    return buf;
+}
+
+} // namespace
+
+TEST_CASE("number_parser: literals", "[number_parser][normal]") {
+    SECTION("grammar") {
+        const char *inputs[] = {
+            "0", "1", "123.12", "0.0001", "1.", "00012.5000", "1e9", "1E+9", "1e-9", "2.5e-3", "1.e5",
+            "0x1p3", "0X1.8P-1", "0xff", "0x.8p1" /*decimal 0, then x*/
+        };
+        const int lengths[] = { 1, 1, 6, 6, 2, 10, 3, 4, 4, 6, 4, 5, 8, 4, 1 };
+
+        for(int i = 0; i < (int) (sizeof(inputs) / sizeof(inputs[0])); ++i) {
+            INFO(inputs[i]);
+            std::string in = inputs[i];
+            double val;
+            REQUIRE(parse_number(in.data(), in.data() + in.size(), val) == in.data() + lengths[i]);
+            REQUIRE(val == std::strtod(in.substr(0, lengths[i]).c_str(), NULL));
+        }
+    }
+
+    SECTION("exponent marker without digits is not part of literal") {
+        const char *inputs[] = { "2e", "2e+", "2E-x", "2p1", "0x1p" };
+        const int lengths[] = { 1, 1, 1, 1, 3 };
+
+        for(int i = 0; i < 5; ++i) {
+            INFO(inputs[i]);
+            std::string in = inputs[i];
+            double val;
+            REQUIRE(parse_number(in.data(), in.data() + in.size(), val) == in.data() + lengths[i]);
+        }
+    }
+
+    SECTION("no literal") {
+        const char *inputs[] = { "", ".5", "x1", "-1", " 1" };
+        for(const char *in : inputs) {
+            double val;
+            REQUIRE(parse_number(in, in + std::strlen(in), val) == in);
+        }
+    }
+
+    SECTION("hard cases") {
+        const char *inputs[] = {
+            "9007199254740993",                     /*2^53 + 1: halfway, rounds to even*/
+            "9007199254740993.0000000000000000001", /*just above halfway*/
+            "2.2250738585072011e-308",              /*largest subnormal*/
+            "2.2250738585072014e-308",              /*smallest normal*/
+            "4.9406564584124654e-324",              /*smallest subnormal*/
+            "2.4703282292062327e-324",              /*halfway to zero*/
+            "2.4703282292062328e-324",
+            "1.7976931348623157e308",
+            "1.7976931348623159e308",               /*overflows*/
+            "1e-400", "1e400", "0e999999999999", "1e-99999999999",
+            "123456789012345678901234567890",
+            "0.000000000000000000000000000000000000000000001234567890123456789012345678901234567890",
+            "7.3177701707893310e+15",
+            "1448997445238699",
+            "179769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177904174497791",
+            "0x1.fffffffffffff8p-1022",
+            "0x1.0000000000000801p0"
+        };
+        for(const char *in : inputs)
+            require_as_strtod(in);
+    }
+}
+
+TEST_CASE("number_parser: round trip against strtod", "[number_parser][differential]") {
+    std::mt19937_64 rng(2323);
+
+    SECTION("printed doubles") {
+        for(int i = 0; i < 100000; ++i) {
+            // random bit patterns cover all exponents and subnormals
+            std::uint64_t bits = rng() & ~(std::uint64_t(1) << 63);
+            double val;
+            std::memcpy(&val, &bits, sizeof(val));
+            if(!std::isfinite(val))
+                continue;
+
+            std::string shortest = printed("%.17g", val);
+            require_as_strtod(shortest);
+            REQUIRE(std::strtod(shortest.c_str(), NULL) == val);
+
+            // fewer digits give values between doubles
+            require_as_strtod(printed(i % 2 ? "%.15e" : "%.6e", val));
+            require_as_strtod(printed("%a", val));
+        }
+    }
+
+    SECTION("random digit strings") {
+        for(int i = 0; i < 100000; ++i) {
+            std::string in;
+            int int_digits = 1 + rng() % 25, frac_digits = rng() % 25;
+            for(int k = 0; k < int_digits; ++k)
+                in += (char) ('0' + rng() % 10);
+            if(frac_digits > 0) {
+                in += '.';
+                for(int k = 0; k < frac_digits; ++k)
+                    in += (char) ('0' + rng() % 10);
+            }
+            if(rng() % 2)
+                in += "e" + std::to_string((int) (rng() % 700) - 350);
+
+            require_as_strtod(in);
+        }
+    }
+}
+
+TEST_CASE("postfix_converter_t: exponent literals", "[postfix_converter_t][normal]") {
+    postfix_converter_t converter;
+
+    REQUIRE(converter.convert("1e-9 * 2").evaluate() == 2e-9);
+    REQUIRE(converter.convert("1.5E3-1e+2").evaluate() == 1400);
+    REQUIRE(converter.convert("0x10 + 0x1p-1").evaluate() == 16.5);
+    REQUIRE(converter.convert("0.1 + 0.2").evaluate() == 0.1 + 0.2);
+    REQUIRE_THROWS(converter.convert("2e"));
+}
+
+} // namespace postfix::lexer
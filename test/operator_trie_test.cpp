@@ -0,0 +1,88 @@
+#include <catch2/catch_all.hpp>
+
+#include "operator_trie.h"
+
+#include <algorithm>
+#include <string>
+
+namespace postfix::detail {
+
+namespace {
+
+// longest match in [in], as string; [first, last) are indices of matched names
+std::string longest(const operator_trie_t& trie, const std::string& in, int& first, int& last) {
+    const char *beg = in.data();
+    return std::string(beg, trie.match(beg, beg + in.size(), first, last));
+}
+
+} // namespace
+
+TEST_CASE("operator_trie_t: longest match", "[operator_trie_t][normal]") {
+    util::vector<std::string> names = { "+", "+", "-", "e", "exp", "expm1", "fma", "log", "log10" };
+    operator_trie_t trie(names);
+    int first, last;
+
+    SECTION("repeated names form one range") {
+        REQUIRE(longest(trie, "+ 1", first, last) == "+");
+        REQUIRE(first == 0);
+        REQUIRE(last == 2);
+    }
+
+    SECTION("the longest name wins") {
+        REQUIRE(longest(trie, "expm1(x)", first, last) == "expm1");
+        REQUIRE(names[first] == "expm1");
+        REQUIRE(last == first + 1);
+
+        REQUIRE(longest(trie, "log10(x)", first, last) == "log10");
+        REQUIRE(longest(trie, "log1(x)", first, last) == "log");
+        REQUIRE(names[first] == "log");
+    }
+
+    SECTION("shorter name is matched, if longer one is cut") {
+        REQUIRE(longest(trie, "expm", first, last) == "exp");
+        REQUIRE(longest(trie, "ex", first, last) == "e");
+    }
+
+    SECTION("no name matches") {
+        REQUIRE(longest(trie, "* 2", first, last).empty());
+        REQUIRE(first == last);
+        REQUIRE(longest(trie, "", first, last).empty());
+        REQUIRE(longest(trie, "fm", first, last).empty());
+    }
+
+    SECTION("length of the longest name") {
+        REQUIRE(trie.get_max_length() == 5);
+        REQUIRE(operator_trie_t().get_max_length() == 0);
+    }
+
+    SECTION("exact names") {
+        REQUIRE(trie.contains("exp"));
+        REQUIRE(trie.contains("+"));
+        REQUIRE_FALSE(trie.contains("ex"));
+        REQUIRE_FALSE(trie.contains("expm12"));
+        REQUIRE_FALSE(trie.contains(""));
+    }
+
+    SECTION("empty trie") {
+        operator_trie_t empty;
+        REQUIRE(longest(empty, "exp", first, last).empty());
+        REQUIRE_FALSE(empty.contains("exp"));
+    }
+}
+
+TEST_CASE("operator_trie_t: many names", "[operator_trie_t][normal]") {
+    util::vector<std::string> names;
+    for(int i = 0; i < 500; ++i)
+        names.push_back("func_" + std::to_string(i));
+    std::sort(names.begin(), names.end());
+
+    operator_trie_t trie(names);
+    for(int i = 0; i < names.size(); ++i) {
+        int first, last;
+        REQUIRE(longest(trie, names[i] + "(1)", first, last) == names[i]);
+        REQUIRE(first == i);
+        REQUIRE(last == i + 1);
+    }
+}
+
+} // namespace postfix::detail
@@ -0,0 +1,79 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "optimizer.h"
+
+#include "expr_generator.h"
+
+namespace postfix::optimizer {
+
+TEST_CASE("optimizer: constant folding", "[optimizer][normal]") {
+    postfix_converter_t converter;
+    postfix_expr_t expr;
+
+    SECTION("folding is on by default") {
+        REQUIRE(converter.get_options().constant_folding);
+    }
+
+    SECTION("constant subexpressions collapse into single number") {
+        expr = converter.convert("2*(3+4)");
+        REQUIRE(expr.get_program().get_code().size() == 1);
+        REQUIRE(expr.evaluate() == 14);
+        REQUIRE(expr.evaluate_tokens() == 14);
+
+        expr = converter.convert("exp(2, 10)");
+        REQUIRE(expr.get_program().get_code().size() == 1);
+        REQUIRE(expr.evaluate() == 1024);
+    }
+
+    SECTION("folding can be disabled") {
+        expr = test::make_unfolded_converter().convert("2*(3+4)");
+        REQUIRE(expr.get_program().get_code().size() > 1);
+        REQUIRE(expr.evaluate() == 14);
+    }
+
+    SECTION("malformed part is left for evaluation") {
+        expr = converter.convert("exp((), 2) + 3 * 4");
+        REQUIRE_THROWS_AS(expr.evaluate(), std::domain_error);
+    }
+}
+
+TEST_CASE("optimizer: fold_constants on tokens", "[optimizer][normal]") {
+    // 1 2 + 3 * -> 9
+    util::vector<token_t> expr = {
+        builder::number(1), builder::number(2), builder::plus(),
+        builder::number(3), builder::multiplication()
+    };
+
+    util::vector<token_t> folded = fold_constants(expr);
+    REQUIRE(folded.size() == 1);
+    REQUIRE(folded[0].get_precedence() == precedence_t::number);
+
+    util::stack<double> st;
+    folded[0].calc_process(st);
+    REQUIRE(st.peek() == 9);
+
+    // operator without enough operands stops folding
+    util::vector<token_t> malformed = {
+        builder::number(2), builder::plus(), builder::number(1), builder::number(2), builder::plus()
+    };
+    REQUIRE(fold_constants(malformed).size() == malformed.size());
+}
+
+TEST_CASE("optimizer: folded value matches evaluation", "[optimizer][differential]") {
+    postfix_converter_t
+        folding = postfix_converter_t(),
+        unfolded = test::make_unfolded_converter();
+    test::expr_generator_t gen(99);
+
+    for(int i = 0; i < 300; ++i) {
+        std::string in = gen.generate(6);
+        postfix_expr_t expr = folding.convert(in);
+
+        INFO(in);
+        REQUIRE(expr.get_program().get_code().size() == 1);
+        REQUIRE(test::same_value(expr.evaluate(), unfolded.convert(in).evaluate_tokens()));
+    }
+}
+
+} // namespace postfix::optimizer
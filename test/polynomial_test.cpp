@@ -0,0 +1,160 @@
+#include <catch2/catch_all.hpp>
+
+#include <cmath>
+#include <random>
+
+#include "postfix.h"
+#include "polynomial.h"
+
+#include "expr_generator.h"
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+// Input of polynomials: not a constant, as exponent is not reduced
+const char *x_str = "exp(2, 0.3)";
+
+// replace every "X" of [pattern] by input
+std::string with_input(const std::string& pattern) {
+    std::string res;
+    for(char c : pattern)
+        res += c == 'X' ? std::string(x_str) : std::string(1, c);
+    return res;
+}
+
+} // namespace
+
+TEST_CASE("polynomial: fma function", "[polynomial][normal]") {
+    postfix_converter_t converter;
+    postfix_expr_t expr;
+
+    expr = converter.convert("fma(2, 3, 4)");
+    REQUIRE(expr.evaluate() == 10);
+    REQUIRE(expr.evaluate_tokens() == 10);
+
+    // rounded once, unlike 0.1 * 10 - 1
+    expr = test::make_plain_converter(&compile_options_t::relaxed_precision, false)
+        .convert("fma(0.1, 10, -1)");
+    REQUIRE(test::count_ops(expr.get_program(), op_t::fma) == 1);
+    REQUIRE(expr.evaluate() == std::fma(0.1, 10, -1));
+    REQUIRE(expr.evaluate() != 0);
+    REQUIRE(expr.evaluate_tokens() == expr.evaluate());
+
+    REQUIRE_THROWS(converter.convert("fma(1, 2)"));
+}
+
+TEST_CASE("polynomial: Horner form", "[polynomial][normal]") {
+    postfix_converter_t converter = test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    postfix_expr_t expr;
+    const double x = std::pow(2, 0.3);
+
+    SECTION("is enabled by default, but requires relaxed precision") {
+        REQUIRE(postfix_converter_t().get_options().polynomials);
+
+        expr = test::make_plain_converter(&compile_options_t::relaxed_precision, false)
+            .convert(with_input("3*X*X*X + 2*X*X - X + 7"));
+        REQUIRE(test::count_ops(expr.get_program(), op_t::fma) == 0);
+    }
+
+    SECTION("naive polynomial") {
+        expr = converter.convert(with_input("3*X*X*X + 2*X*X - X + 7"));
+        const bytecode::program_t& prog = expr.get_program();
+
+        REQUIRE(test::count_ops(prog, op_t::fma) == 3);
+        REQUIRE(test::count_ops(prog, op_t::mul) == 0);
+        REQUIRE(test::count_ops(prog, op_t::pow) == 1); /*input itself*/
+        REQUIRE(expr.get_rewrites().size() == 1);
+        REQUIRE(expr.get_rewrites()[0].description ==
+            "polynomial of degree 3 (8 operators) -> Horner form (3 operators)");
+
+        REQUIRE(expr.evaluate() == std::fma(std::fma(std::fma(3, x, 2), x, -1), x, 7));
+    }
+
+    SECTION("powers, products and divisions by constants") {
+        expr = converter.convert(with_input("exp(X + 1, 2) / 2 - (X - 1) * (X + 1)"));
+        // (x^2 + 2x + 1) / 2 - (x^2 - 1) = -0.5x^2 + x + 1.5
+        REQUIRE(test::count_ops(expr.get_program(), op_t::fma) == 2);
+        REQUIRE(expr.evaluate() == std::fma(std::fma(-0.5, x, 1), x, 1.5));
+    }
+
+    SECTION("linear polynomial") {
+        expr = converter.convert(with_input("3 * X + 1"));
+        REQUIRE(test::count_ops(expr.get_program(), op_t::fma) == 1);
+        REQUIRE(expr.evaluate() == std::fma(3, x, 1));
+    }
+
+    SECTION("polynomials, which are not worth rewriting") {
+        // x^3 + x^2 needs 3 operators in either form
+        expr = converter.convert(with_input("X * X * (X + 1)"));
+        REQUIRE(test::count_ops(expr.get_program(), op_t::fma) == 0);
+        REQUIRE(expr.get_rewrites().empty());
+    }
+
+    SECTION("cancelled terms are removed") {
+        postfix_converter_t var_converter =
+            test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+        var_converter.add_variable("x");
+        expr = var_converter.convert("x*x - x*x + x");
+        REQUIRE(expr.get_program().get_code().size() == 1);
+
+        // inf - inf is not 0: result is infinity instead of NaN
+        double inf = HUGE_VAL;
+        REQUIRE(expr.evaluate_at(&inf) == HUGE_VAL);
+
+        postfix_converter_t strict_converter =
+            test::make_plain_converter(&compile_options_t::relaxed_precision, false);
+        strict_converter.add_variable("x");
+        REQUIRE(std::isnan(strict_converter.convert("x*x - x*x + x").evaluate_at(&inf)));
+    }
+
+    SECTION("polynomial inside other expression") {
+        expr = converter.convert(with_input("exp(2*X*X + 3*X + 1, 0.3) + 1"));
+        REQUIRE(test::count_ops(expr.get_program(), op_t::fma) == 2);
+        REQUIRE(expr.evaluate() == std::pow(std::fma(std::fma(2, x, 3), x, 1), 0.3) + 1);
+    }
+}
+
+TEST_CASE("polynomial: random polynomials", "[polynomial][differential]") {
+    postfix_converter_t converter = test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    std::mt19937 rng(1010);
+    const long double x = std::pow(2.0, 0.3);
+
+    const backend_t backends[] = {
+        backend_t::switch_dispatch,
+        backend_t::threaded,
+        backend_t::register_vm,
+        backend_t::jit
+    };
+
+    for(int i = 0; i < 200; ++i) {
+        int degree = std::uniform_int_distribution<int>(1, 8)(rng);
+
+        // c0 + c1 * x + c2 * x * x + ...
+        std::string in;
+        long double exact = 0, magnitude = 0;
+        for(int k = 0; k <= degree; ++k) {
+            int c = std::uniform_int_distribution<int>(-5, 5)(rng);
+            in += (k == 0 ? "" : " + ") + std::string("(") + std::to_string(c) + ")";
+            for(int j = 0; j < k; ++j)
+                in += " * X";
+
+            exact += c * std::pow(x, (long double) k);
+            magnitude += std::fabs(c * std::pow(x, (long double) k));
+        }
+
+        postfix_expr_t expr = converter.convert(with_input(in));
+        double value = expr.evaluate();
+
+        INFO(in);
+        REQUIRE(std::fabs(value - exact) <= 1e-14 * magnitude);
+        for(backend_t backend : backends) {
+            expr.set_backend(backend);
+            REQUIRE(expr.evaluate() == value);
+        }
+    }
+}
+
+} // namespace postfix::optimizer
@@ -4,6 +4,9 @@
 
 #include "postfix.h"
 
+#include <algorithm>
+#include <string_view>
+
 namespace postfix::detail {
 
 // Methods of postfix_converter_impl_t are private, thus friend class is used
@@ -258,4 +261,36 @@ TEST_CASE("postfix_converter_t: parenthesis and commas", "[postfix_converter_t]"
 
 }
 
+TEST_CASE("postfix_converter_t: conversion of ranges", "[postfix_converter_t]") {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+
+    // lines of buffer, which is not null-terminated after any of them
+    const char buffer[] = "1 + 2\n(x * 3)   \n12345\n4 *\n(5 - 1\n6)";
+    const char *lines[12]; /*begin and end of every line*/
+    int num_bounds = 0;
+    for(const char *beg = buffer, *end = buffer + sizeof(buffer) - 1; beg <= end; beg = lines[num_bounds - 1] + 1) {
+        lines[num_bounds++] = beg;
+        lines[num_bounds++] = std::find(beg, end, '\n');
+    }
+    REQUIRE(num_bounds == 12);
+
+    double x = 2;
+    REQUIRE(converter.convert(lines[0], lines[1]).evaluate() == 3);
+    REQUIRE(converter.convert(lines[2], lines[3]).evaluate_at(&x) == 6);
+    REQUIRE(converter.convert(lines[4], lines[5]).evaluate() == 12345);
+    REQUIRE(converter.convert(lines[4], lines[4] + 2).evaluate() == 12); /*digits after range are not read*/
+
+    REQUIRE_THROWS(converter.convert(lines[6], lines[7]));
+    REQUIRE_THROWS(converter.convert(lines[8], lines[9]));
+    REQUIRE_THROWS(converter.convert(lines[10], lines[11]));
+
+    // string_view of the same lines
+    REQUIRE(converter.convert(std::string_view(lines[0], lines[1] - lines[0])).evaluate() == 3);
+
+    // implicit parentheses enclose empty and whitespace-only ranges
+    REQUIRE_NOTHROW(converter.convert(buffer, buffer));
+    REQUIRE_NOTHROW(converter.convert("   "));
+}
+
 } // namespace postfix
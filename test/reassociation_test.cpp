@@ -0,0 +1,182 @@
+#include <catch2/catch_all.hpp>
+
+#include <cmath>
+#include <random>
+
+#include "postfix.h"
+#include "reassociation.h"
+
+#include "expr_generator.h"
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+// Length of longest chain of dependent operators of [prog]
+int critical_path(const bytecode::program_t& prog) {
+    expr_dag_t dag;
+    REQUIRE(expr_dag_t::from_program(prog, false, dag));
+
+    util::vector<int> height(dag.size(), 0);
+    for(int i = 0; i < dag.size(); ++i) {
+        const dag_node_t& node = dag.get_node(i);
+        if(node.op == op_t::push_const)
+            continue;
+
+        for(int j = 0; j < node.num_children; ++j)
+            height[i] = std::max(height[i], height[node.children[j]]);
+        ++height[i];
+    }
+
+    return height[dag.get_root()];
+}
+
+// k * u / (1 - k * u)
+double gamma_bound(int k) {
+    const double u = std::ldexp(1.0, -53);
+    return k * u / (1 - k * u);
+}
+
+int ceil_log2(int n) {
+    int res = 0;
+    while((1 << res) < n)
+        ++res;
+    return res;
+}
+
+} // namespace
+
+TEST_CASE("reassociation: balanced trees", "[reassociation][normal]") {
+    postfix_converter_t converter = test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    postfix_expr_t expr;
+
+    SECTION("is enabled by default, but requires relaxed precision") {
+        REQUIRE(postfix_converter_t().get_options().reassociation);
+
+        expr = test::make_plain_converter(&compile_options_t::relaxed_precision, false)
+            .convert("1 + 2 + 3 + 4 + 5 + 6 + 7 + 8");
+        REQUIRE(critical_path(expr.get_program()) == 7);
+        REQUIRE(expr.get_rewrites().empty());
+    }
+
+    SECTION("sum") {
+        std::string in = "1";
+        for(int i = 2; i <= 1024; ++i)
+            in += " + " + std::to_string(i);
+
+        expr = converter.convert(in);
+        REQUIRE(critical_path(expr.get_program()) == 10);
+        REQUIRE(expr.evaluate() == 1024 * 1025 / 2);
+
+        REQUIRE(expr.get_rewrites().size() == 1);
+        REQUIRE(expr.get_rewrites()[0].rule == std::string("sum_to_balanced"));
+        REQUIRE(expr.get_rewrites()[0].description ==
+            "sum of 1024 terms (depth 1023) -> balanced tree (depth 10)");
+    }
+
+    SECTION("subtracted terms are summed separately") {
+        expr = converter.convert("1 - 2 + 3 - 4 + 5 - (6 + 7 - 8) - 9");
+        // (1 + 3 + 5 + 8) - (2 + 4 + 6 + 7 + 9)
+        REQUIRE(critical_path(expr.get_program()) == 4);
+        REQUIRE(expr.evaluate() == -11);
+    }
+
+    SECTION("product") {
+        expr = converter.convert("1.5 * 2 * 3 * 4 * 5 * 6 * 7 * 8");
+        REQUIRE(critical_path(expr.get_program()) == 3);
+        REQUIRE(expr.evaluate() == 1.5 * 40320);
+        REQUIRE(expr.get_rewrites()[0].rule == std::string("product_to_balanced"));
+    }
+
+    SECTION("chains, which are not made shorter, are kept") {
+        expr = converter.convert("1 + 2 + 3");
+        REQUIRE(expr.get_rewrites().empty());
+
+        expr = converter.convert("(1 + 2) * (3 + 4)");
+        REQUIRE(expr.get_rewrites().empty());
+    }
+
+    SECTION("shared subexpressions stay terms") {
+        // 1 + 2 + 3 is computed once and used twice
+        expr = converter.convert("(1 + 2 + 3) * 4 + (1 + 2 + 3) + 5 + 6 + 7");
+        REQUIRE(expr.evaluate() == 24 + 6 + 18);
+        REQUIRE(expr.get_program().get_num_temps() == 1);
+    }
+}
+
+TEST_CASE("reassociation: error bound", "[reassociation][differential]") {
+    postfix_converter_t relaxed = test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    postfix_converter_t strict = test::make_plain_converter(&compile_options_t::relaxed_precision, false);
+    std::mt19937 rng(1313);
+
+    const backend_t backends[] = {
+        backend_t::switch_dispatch,
+        backend_t::threaded,
+        backend_t::register_vm,
+        backend_t::jit,
+        backend_t::slp
+    };
+
+    SECTION("sums") {
+        for(int i = 0; i < 50; ++i) {
+            int n = std::uniform_int_distribution<int>(3, 2000)(rng);
+
+            std::string in;
+            double magnitude = 0;
+            for(int k = 0; k < n; ++k) {
+                double x = std::uniform_real_distribution<double>(0, 1e6)(rng);
+                std::string term = std::to_string(x);
+                in += (k == 0 ? "" : (rng() % 2 ? " + " : " - ")) + term;
+                magnitude += std::stod(term);
+            }
+
+            postfix_expr_t expr = relaxed.convert(in);
+            double value = expr.evaluate();
+            double expected = strict.convert(in).evaluate();
+
+            INFO(n);
+            REQUIRE(std::fabs(value - expected) <= (gamma_bound(n - 1) + gamma_bound(ceil_log2(n) + 1)) * magnitude * 1.01);
+            for(backend_t backend : backends) {
+                expr.set_backend(backend);
+                REQUIRE(expr.evaluate() == value);
+            }
+        }
+    }
+
+    SECTION("products") {
+        for(int i = 0; i < 50; ++i) {
+            int n = std::uniform_int_distribution<int>(3, 200)(rng);
+
+            std::string in;
+            for(int k = 0; k < n; ++k) {
+                double x = std::uniform_real_distribution<double>(0.5, 2)(rng);
+                in += (k == 0 ? "" : " * ") + std::to_string(x);
+            }
+
+            double value = relaxed.convert(in).evaluate();
+            double expected = strict.convert(in).evaluate();
+
+            INFO(n);
+            REQUIRE(std::fabs(value - expected) <= 2 * gamma_bound(n - 1) * std::fabs(expected) * 1.01);
+        }
+    }
+}
+
+TEST_CASE("reassociation: differential test", "[reassociation][differential]") {
+    postfix_converter_t relaxed = test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    postfix_converter_t strict = test::make_plain_converter(&compile_options_t::relaxed_precision, false);
+    test::expr_generator_t gen(1313);
+
+    for(int i = 0; i < 500; ++i) {
+        std::string in = gen.generate(7);
+        double value = relaxed.convert(in).evaluate();
+        double expected = strict.convert(in).evaluate();
+
+        INFO(in);
+        REQUIRE((test::same_value(value, expected) || std::fabs(value - expected) <= 1e-9 * std::fabs(expected)));
+    }
+}
+
+} // namespace postfix::optimizer
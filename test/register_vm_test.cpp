@@ -0,0 +1,79 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "register_vm.h"
+
+#include "expr_generator.h"
+
+namespace postfix::bytecode {
+
+TEST_CASE("register_vm: lowering", "[register_vm][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+
+    SECTION("constants are used in place") {
+        // 2 3 4 + * -> r0 = 3 + 4; r0 = 2 * r0
+        postfix_expr_t expr = converter.convert("2 * (3 + 4)");
+        register_program_t reg_prog(expr.get_program());
+
+        REQUIRE(reg_prog.lowered());
+        REQUIRE(reg_prog.get_code().size() == 2);
+        REQUIRE(reg_prog.get_num_registers() <= expr.get_program().get_max_depth());
+
+        double regs[register_program_t::max_registers];
+        REQUIRE(reg_prog.run(regs) == 14);
+    }
+
+    SECTION("single constant") {
+        postfix_expr_t expr = converter.convert("5");
+        register_program_t reg_prog(expr.get_program());
+
+        REQUIRE(reg_prog.lowered());
+        REQUIRE(reg_prog.get_code().empty());
+
+        double regs[1];
+        REQUIRE(reg_prog.run(regs) == 5);
+    }
+
+    SECTION("invalid program is not lowered") {
+        postfix_expr_t expr = converter.convert("exp((), 2)");
+        register_program_t reg_prog(expr.get_program());
+
+        REQUIRE_FALSE(reg_prog.lowered());
+    }
+}
+
+TEST_CASE("register_vm: too deep expression falls back to stack machine", "[register_vm][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    compile_options_t options = converter.get_options();
+    options.scheduling = false;
+    converter.set_options(options);
+
+    // right-leaning nesting keeps every operand on stack (unless operands are scheduled)
+    std::string in = "1";
+    for(int i = 0; i < register_program_t::max_registers + 10; ++i)
+        in = "1 + (" + in + ")";
+
+    postfix_expr_t expr = converter.convert(in);
+    REQUIRE_FALSE(register_program_t(expr.get_program()).lowered());
+
+    expr.set_backend(backend_t::register_vm);
+    REQUIRE(expr.evaluate() == register_program_t::max_registers + 11);
+}
+
+TEST_CASE("register_vm: differential test against stack machine", "[register_vm][differential]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    test::expr_generator_t gen(42);
+
+    for(int i = 0; i < 500; ++i) {
+        std::string in = gen.generate(6);
+        postfix_expr_t expr = converter.convert(in);
+
+        double expected = expr.evaluate();
+        expr.set_backend(backend_t::register_vm);
+
+        INFO(in);
+        REQUIRE(test::same_value(expr.evaluate(), expected));
+    }
+}
+
+} // namespace postfix::bytecode
@@ -0,0 +1,127 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "scheduling.h"
+
+#include "expr_generator.h"
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+// [num] right-leaning applications of [op]: 1 op (2 op (3 op ...))
+std::string right_leaning(const std::string& op, int num) {
+    std::string res = "1.5";
+    for(int i = num; i > 0; --i)
+        res = std::to_string(i % 7 + 1) + " " + op + " (" + res + ")";
+    return res;
+}
+
+} // namespace
+
+TEST_CASE("scheduling: Sethi-Ullman numbers", "[scheduling][normal]") {
+    expr_dag_t dag;
+    int one = dag.make_const(1), two = dag.make_const(2);
+
+    int sum = dag.make_binary(op_t::add, one, two);         // 2
+    int prod = dag.make_binary(op_t::mul, sum, sum);        // 3, dup is not taken into account
+    int diff = dag.make_binary(op_t::sub, one, prod);       // 3, if prod goes first
+    int neg = dag.make_unary(op_t::neg, diff);              // 3
+    int children[3] = { one, two, neg };
+    int fma = dag.make_node(op_t::fma, 3, children);        // 5, operands are not reordered
+
+    util::vector<int> need = sethi_ullman_numbers(dag);
+    REQUIRE(need[one] == 1);
+    REQUIRE(need[sum] == 2);
+    REQUIRE(need[prod] == 3);
+    REQUIRE(need[diff] == 3);
+    REQUIRE(need[neg] == 3);
+    REQUIRE(need[fma] == 5);
+
+    util::vector<bool> reversed = schedule_operands(dag);
+    REQUIRE_FALSE(reversed[sum]);
+    REQUIRE_FALSE(reversed[prod]);
+    REQUIRE(reversed[diff]);
+    REQUIRE_FALSE(reversed[fma]);
+
+    REQUIRE(reversed_operator(op_t::add) == op_t::add);
+    REQUIRE(reversed_operator(op_t::sub) == op_t::rsub);
+    REQUIRE(reversed_operator(op_t::div) == op_t::rdiv);
+    REQUIRE(reversed_operator(op_t::pow) == op_t::rpow);
+    REQUIRE(reversed_operator(op_t::fma) == op_t::nop);
+}
+
+TEST_CASE("scheduling: right-leaning expressions", "[scheduling][normal]") {
+    postfix_converter_t converter = test::make_plain_converter(&compile_options_t::scheduling, true);
+    postfix_converter_t source_order = test::make_plain_converter(&compile_options_t::scheduling, false);
+
+    REQUIRE(postfix_converter_t().get_options().scheduling);
+
+    SECTION("commutative operators") {
+        std::string in = right_leaning("+", 1000);
+        REQUIRE(source_order.convert(in).get_program().get_max_depth() == 1001);
+
+        postfix_expr_t expr = converter.convert(in);
+        REQUIRE(expr.get_program().get_max_depth() == 2);
+        REQUIRE(expr.evaluate() == source_order.convert(in).evaluate());
+    }
+
+    SECTION("non-commutative operators are reversed") {
+        const char *ops[] = { "-", "/" };
+        const op_t reversed_ops[] = { op_t::rsub, op_t::rdiv };
+
+        for(int i = 0; i < 2; ++i) {
+            std::string in = right_leaning(ops[i], 5000);
+            postfix_expr_t expr = converter.convert(in);
+            postfix_expr_t expected = source_order.convert(in);
+
+            REQUIRE(expr.get_program().get_max_depth() == 2);
+            REQUIRE(test::count_ops(expr.get_program(), reversed_ops[i]) == 4999); /*innermost operands are leaves*/
+            REQUIRE(expr.get_program().get_code().size() == expected.get_program().get_code().size());
+            REQUIRE(test::same_value(expr.evaluate(), expected.evaluate()));
+        }
+    }
+
+    SECTION("exponent, which is heavier than base") {
+        postfix_expr_t expr = converter.convert("exp(2, 1 + 2 * (3 - 1 / 4))");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::rpow) == 1);
+        REQUIRE(expr.get_program().get_max_depth() == 2);
+        REQUIRE(expr.evaluate() == source_order.convert("exp(2, 1 + 2 * (3 - 1 / 4))").evaluate());
+    }
+
+    SECTION("balanced operands keep source order") {
+        postfix_expr_t expr = converter.convert("(1 - 2) - (3 - 4)");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::rsub) == 0);
+        REQUIRE(expr.get_program().get_max_depth() == 3);
+    }
+}
+
+TEST_CASE("scheduling: differential test against source order", "[scheduling][differential]") {
+    postfix_converter_t source_order = test::make_plain_converter(&compile_options_t::scheduling, false);
+    postfix_converter_t converter = test::make_unfolded_converter();
+    test::expr_generator_t gen(1111);
+
+    const backend_t backends[] = {
+        backend_t::switch_dispatch,
+        backend_t::threaded,
+        backend_t::register_vm,
+        backend_t::jit
+    };
+
+    for(int i = 0; i < 500; ++i) {
+        std::string in = gen.generate(7);
+        postfix_expr_t expected = source_order.convert(in);
+        postfix_expr_t expr = converter.convert(in);
+
+        INFO(in);
+        REQUIRE(expr.get_program().get_max_depth() <= expected.get_program().get_max_depth());
+        for(backend_t backend : backends) {
+            expr.set_backend(backend);
+            REQUIRE(test::same_value(expr.evaluate(), expected.evaluate()));
+        }
+    }
+}
+
+} // namespace postfix::optimizer
@@ -0,0 +1,110 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "shapes.h"
+
+#include "expr_generator.h"
+
+#include <string>
+
+namespace postfix::simd {
+
+namespace {
+
+const isa_t isas[] = { isa_t::scalar, isa_t::sse2, isa_t::avx2, isa_t::avx512 };
+
+} // namespace
+
+TEST_CASE("shapes: bucketing", "[shapes][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    converter.add_variable("x");
+
+    SECTION("expressions, which differ only in constants, share shape") {
+        shape_set_t set;
+        REQUIRE(set.add(converter.convert("2 * x + 3").get_program()) == 0);
+        REQUIRE(set.add(converter.convert("0.5 * x + 100").get_program()) == 1);
+        REQUIRE(set.add(converter.convert("2 * x - 3").get_program()) == 2);
+        REQUIRE(set.add(converter.convert("(2 * x) + 3").get_program()) == 3);
+
+        REQUIRE(set.size() == 4);
+        REQUIRE(set.get_num_shapes() == 2);
+
+        double x = 4;
+        double results[4];
+        set.evaluate_all(results, &x);
+        REQUIRE(results[0] == 11);
+        REQUIRE(results[1] == 102);
+        REQUIRE(results[2] == 5);
+        REQUIRE(results[3] == 11);
+    }
+
+    SECTION("invalid program") {
+        shape_set_t set;
+        REQUIRE_THROWS(set.add(converter.convert("x + ()").get_program()));
+        REQUIRE(set.size() == 0);
+    }
+
+    SECTION("values of variables are required") {
+        shape_set_t set;
+        set.add(converter.convert("x + 1").get_program());
+
+        double result;
+        REQUIRE_THROWS_AS(set.evaluate_all(&result), std::logic_error);
+    }
+
+    SECTION("expressions without variables") {
+        shape_set_t set;
+        set.add(converter.convert("1 + 2 * 3").get_program());
+        set.add(converter.convert("4 + 5 * 6").get_program());
+        REQUIRE(set.get_num_shapes() == 1);
+
+        double results[2];
+        set.evaluate_all(results);
+        REQUIRE(results[0] == 7);
+        REQUIRE(results[1] == 34);
+    }
+}
+
+TEST_CASE("shapes: differential test against evaluate_at", "[shapes][differential]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    converter.add_variable("x");
+    converter.add_variable("y");
+    test::expr_generator_t gen(1616);
+
+    // few skeletons, many constants: buckets span several blocks
+    util::vector<postfix_expr_t> exprs;
+    for(int i = 0; i < 3000; ++i) {
+        std::string in;
+        switch(i % 4) {
+        case 0: in = gen.generate(0) + " * x + " + gen.generate(0); break;
+        case 1: in = "exp(x - " + gen.generate(0) + ", 2) / (y + " + gen.generate(0) + ")"; break;
+        case 2: in = "fma(x, " + gen.generate(0) + ", y) * " + gen.generate(0); break;
+        default: in = gen.generate(3) + " * y"; break;
+        }
+        exprs.push_back(converter.convert(in));
+    }
+
+    double values[] = { 1.75, -0.5 };
+    util::vector<double> expected;
+    for(int i = 0; i < exprs.size(); ++i)
+        expected.push_back(exprs[i].evaluate_at(values));
+
+    for(isa_t isa : isas) {
+        if(!isa_supported(isa))
+            continue;
+
+        shape_set_t set(isa);
+        for(int i = 0; i < exprs.size(); ++i)
+            set.add(exprs[i].get_program());
+        REQUIRE(set.get_num_shapes() < exprs.size() / 2);
+
+        util::vector<double> results(exprs.size());
+        set.evaluate_all(results.begin(), values);
+
+        INFO(isa_name(isa));
+        for(int i = 0; i < exprs.size(); ++i)
+            REQUIRE(test::same_value(results[i], expected[i]));
+    }
+}
+
+} // namespace postfix::simd
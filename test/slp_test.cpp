@@ -0,0 +1,138 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "slp.h"
+
+#include "expr_generator.h"
+
+namespace postfix::simd {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+// widths of [op] instructions of [prog], in order
+util::vector<int> widths_of(const slp_program_t& prog, op_t op) {
+    util::vector<int> res;
+    for(int i = 0; i < prog.get_code().size(); ++i)
+        if(prog.get_code()[i].op == op)
+            res.push_back(prog.get_code()[i].width);
+    return res;
+}
+
+double run(const slp_program_t& prog) {
+    util::vector<double> slots(prog.get_num_slots() + 1);
+    return prog.run(slots.begin());
+}
+
+const isa_t isas[] = { isa_t::scalar, isa_t::sse2, isa_t::avx2 };
+
+} // namespace
+
+TEST_CASE("slp: packing", "[slp][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+
+    SECTION("independent products") {
+        postfix_expr_t expr = converter.convert("(1.5 * 2.5) + (3.5 * 4.5) + (5.5 * 6.5) + (7.5 * 8.5)");
+        double expected = expr.evaluate();
+
+        for(isa_t isa : isas) {
+            if(!isa_supported(isa))
+                continue;
+
+            slp_program_t packed(expr.get_program(), isa);
+            REQUIRE(packed.packed());
+            REQUIRE(run(packed) == expected);
+
+            util::vector<int> muls = widths_of(packed, op_t::mul);
+            int lanes = isa_lanes(isa);
+            REQUIRE(muls.size() == 4 / lanes);
+            for(int i = 0; i < muls.size(); ++i)
+                REQUIRE(muls[i] == lanes);
+
+            // chain of sums stays scalar
+            REQUIRE(widths_of(packed, op_t::add) == util::vector<int>({ 1, 1, 1 }));
+        }
+    }
+
+    SECTION("operands of next level are loaded at once") {
+        if(!isa_supported(isa_t::sse2))
+            return;
+
+        postfix_expr_t expr = converter.convert("(1 * 2 + 3 * 4) + (5 * 6 + 7 * 8)");
+        slp_program_t packed(expr.get_program(), isa_t::sse2);
+        REQUIRE(run(packed) == 100);
+
+        const slp_instruction_t& add = packed.get_code()[2];
+        REQUIRE(add.op == op_t::add);
+        REQUIRE(add.width == 2);
+        REQUIRE(add.load[0] == lane_load_t::contiguous);
+        REQUIRE(add.load[1] == lane_load_t::contiguous);
+    }
+
+    SECTION("same operand of all lanes is broadcast") {
+        if(!isa_supported(isa_t::sse2))
+            return;
+
+        postfix_expr_t expr = converter.convert("(1 - 3) * (2 - 3)");
+        slp_program_t packed(expr.get_program(), isa_t::sse2);
+        REQUIRE(packed.get_code()[0].op == op_t::sub);
+        REQUIRE(packed.get_code()[0].width == 2);
+        REQUIRE(packed.get_code()[0].load[1] == lane_load_t::broadcast);
+        REQUIRE(run(packed) == 2);
+    }
+
+    SECTION("operators without vector form are computed lane by lane") {
+        postfix_expr_t expr = converter.convert("exp(2, 0.3) + exp(3, 0.7) + fma(1, 2, 3) * fma(4, 5, 6)");
+        double expected = expr.evaluate();
+
+        for(isa_t isa : isas) {
+            if(isa_supported(isa))
+                REQUIRE(run(slp_program_t(expr.get_program(), isa)) == expected);
+        }
+    }
+
+    SECTION("invalid program is not packed") {
+        postfix_expr_t expr = converter.convert("exp((), 2)");
+        REQUIRE_FALSE(slp_program_t(expr.get_program()).packed());
+
+        expr.set_backend(backend_t::slp);
+        REQUIRE_THROWS(expr.evaluate());
+    }
+}
+
+TEST_CASE("slp: backend", "[slp][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    postfix_expr_t expr = converter.convert("1 * 2 + 3 * 4 + 5 * 6 + 7 * 8 + 9 * 10");
+    int stack_size = expr.get_scratch_size();
+
+    expr.set_backend(backend_t::slp);
+    REQUIRE(expr.get_backend() == backend_t::slp);
+    REQUIRE(expr.get_scratch_size() > stack_size); /*every value has its own slot*/
+    REQUIRE(expr.evaluate() == 190);
+
+    util::vector<double> scratch(expr.get_scratch_size());
+    REQUIRE(expr.evaluate(scratch.begin()) == 190);
+}
+
+TEST_CASE("slp: differential test against switch interpreter", "[slp][differential]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    test::expr_generator_t gen(1212);
+
+    for(int i = 0; i < 1000; ++i) {
+        std::string in = gen.generate(7);
+        postfix_expr_t expr = converter.convert(in);
+        double expected = expr.evaluate();
+
+        INFO(in);
+        for(isa_t isa : isas) {
+            if(isa_supported(isa))
+                REQUIRE(test::same_value(run(slp_program_t(expr.get_program(), isa)), expected));
+        }
+
+        expr.set_backend(backend_t::slp);
+        REQUIRE(test::same_value(expr.evaluate(), expected));
+    }
+}
+
+} // namespace postfix::simd
@@ -0,0 +1,156 @@
+#include <catch2/catch_all.hpp>
+
+#include "stream.h"
+
+#include "expr_generator.h"
+
+#include <random>
+#include <string>
+
+namespace postfix {
+
+namespace {
+
+// Evaluates tokens, as they leave stream converter
+class stream_evaluator_t {
+public:
+    explicit stream_evaluator_t(const postfix_converter_t& converter):
+        stream(converter, [this](token_t& token) {
+            token.calc_process(values);
+            names += token.get_name() + " ";
+        })
+    {}
+
+    // feeds [in] in chunks of random sizes up to [max_chunk]
+    double evaluate(const std::string& in, int max_chunk, std::mt19937& rng) {
+        while(!values.empty())
+            values.pop();
+        names.clear();
+
+        for(std::size_t pos = 0; pos < in.size(); ) {
+            std::size_t size = 1 + rng() % max_chunk;
+            stream.feed(std::string_view(in).substr(pos, size));
+            pos += size;
+        }
+        stream.finish();
+
+        REQUIRE(values.size() == 1);
+        return values.peek();
+    }
+
+    stream_converter_t stream;
+    util::stack<double> values;
+    std::string names; /*of emitted tokens*/
+};
+
+} // namespace
+
+TEST_CASE("stream_converter_t: chunks split anywhere", "[stream_converter_t][normal]") {
+    postfix_converter_t converter;
+    stream_evaluator_t eval(converter);
+    std::mt19937 rng(2525);
+
+    SECTION("tokens, split across chunks") {
+        const char *inputs[] = {
+            "123456.789 + 2",
+            "fma(1.5e-3, 2E+2, 0x1.8p1) - exp(2, 10)",
+            "1e5-1",
+            "  ( ( 7 ) )  ",
+            "12345678901234567890123 * 0.000000000000000000001",
+        };
+
+        for(const char *in : inputs) {
+            double expected = converter.convert(in).evaluate_tokens();
+            for(int max_chunk = 1; max_chunk <= 8; ++max_chunk)
+                for(int k = 0; k < 20; ++k) {
+                    INFO(in);
+                    INFO(max_chunk);
+                    REQUIRE(eval.evaluate(in, max_chunk, rng) == expected);
+                }
+        }
+    }
+
+    SECTION("postfix order of tokens") {
+        eval.evaluate("1 + 2 * exp(3, 2) - 4", 3, rng);
+        REQUIRE(eval.names == "(number) (number) (number) (number) exp * + (number) - ");
+    }
+
+    SECTION("generated expressions") {
+        test::expr_generator_t gen(2525);
+        for(int i = 0; i < 300; ++i) {
+            std::string in = gen.generate(6);
+            double expected = converter.convert(in).evaluate_tokens();
+
+            INFO(in);
+            REQUIRE(test::same_value(eval.evaluate(in, 1 + i % 16, rng), expected));
+        }
+    }
+}
+
+TEST_CASE("stream_converter_t: variables and functions of converter", "[stream_converter_t][normal]") {
+    postfix_converter_t converter;
+    converter.add_variable("x");
+    converter.add_variable("xyz");
+
+    std::string names;
+    stream_converter_t stream(converter, [&](token_t& token) { names += token.get_name() + " "; });
+
+    // variable "x" is prefix of variable "xyz", "ex" is prefix of function "exp"
+    const char *chunks[] = { "x", "y", "z * ex", "p(x", ", 2)" };
+    for(const char *chunk : chunks)
+        stream.feed(chunk);
+    stream.finish();
+
+    REQUIRE(names == "xyz x (number) exp * ");
+}
+
+TEST_CASE("stream_converter_t: errors", "[stream_converter_t][normal]") {
+    postfix_converter_t converter;
+    int num_tokens = 0;
+    stream_converter_t stream(converter, [&](token_t&) { ++num_tokens; });
+
+    SECTION("misplaced token is reported, once it is decided") {
+        stream.feed("1 + ");
+        REQUIRE_THROWS(stream.feed("* 2 + 3 + 4"));
+    }
+
+    SECTION("unbalanced parentheses are reported by finish") {
+        stream.feed("(1 + 2");
+        REQUIRE_THROWS(stream.finish());
+    }
+
+    SECTION("incomplete expression") {
+        stream.feed("1 +");
+        REQUIRE_THROWS(stream.finish());
+    }
+
+    // converter is reset after error
+    num_tokens = 0;
+    stream.feed("2 * 3");
+    stream.finish();
+    REQUIRE(num_tokens == 3);
+}
+
+TEST_CASE("stream_converter_t: memory is bounded by nesting depth", "[stream_converter_t][normal]") {
+    postfix_converter_t converter;
+    util::stack<double> values;
+    stream_converter_t stream(converter, [&](token_t& token) { token.calc_process(values); });
+
+    // long flat sum in chunks: operators leave stack as soon as the next one arrives
+    std::string chunk;
+    for(int i = 0; i < 1000; ++i)
+        chunk += "1.25 * 2 + ";
+
+    int max_buffered = 0;
+    for(int k = 0; k < 100; ++k) {
+        stream.feed(chunk);
+        max_buffered = std::max(max_buffered, stream.get_buffered_size());
+    }
+    stream.feed("1");
+    stream.finish();
+
+    REQUIRE(values.peek() == 100 * 1000 * 2.5 + 1);
+    REQUIRE(max_buffered < 16);
+}
+
+} // namespace postfix
@@ -0,0 +1,181 @@
+#include <catch2/catch_all.hpp>
+
+#include <cmath>
+
+#include "postfix.h"
+#include "strength_reduction.h"
+
+#include "expr_generator.h"
+
+namespace postfix::optimizer {
+
+namespace {
+
+typedef bytecode::opcode_t op_t;
+
+bool has_rewrite(const postfix_expr_t& expr, const std::string& rule, const std::string& description) {
+    const util::vector<rewrite_t>& rewrites = expr.get_rewrites();
+    for(int i = 0; i < rewrites.size(); ++i)
+        if(rewrites[i].rule == rule && rewrites[i].description == description)
+            return true;
+
+    return false;
+}
+
+// [a] and [b] differ at most by a few roundings
+bool close(double a, double b) {
+    return test::same_value(a, b) || std::fabs(a - b) <= 1e-9 * std::fabs(b);
+}
+
+} // namespace
+
+TEST_CASE("strength_reduction: exact rewrites", "[strength_reduction][normal]") {
+    postfix_converter_t converter = test::make_plain_converter(&compile_options_t::relaxed_precision, false);
+    postfix_expr_t expr;
+
+    SECTION("is on by default, precision is strict by default") {
+        REQUIRE(postfix_converter_t().get_options().strength_reduction);
+        REQUIRE_FALSE(postfix_converter_t().get_options().relaxed_precision);
+    }
+
+    SECTION("trivial exponents") {
+        expr = converter.convert("exp(1 + 2, 0) + exp(1 + 2, 1)");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::pow) == 0);
+        REQUIRE(has_rewrite(expr, "pow_to_const", "exp(x, 0) -> 1"));
+        REQUIRE(has_rewrite(expr, "pow_to_identity", "exp(x, 1) -> x"));
+        REQUIRE(expr.evaluate() == 4);
+    }
+
+    SECTION("half becomes sqrt") {
+        expr = converter.convert("exp(1 + 1, 0.5)");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::sqrt) == 1);
+        REQUIRE(has_rewrite(expr, "pow_to_sqrt", "exp(x, 0.5) -> sqrt(x)"));
+        REQUIRE(expr.evaluate() == std::pow(2, 0.5));
+
+        // sqrt behaves as pow on special values
+        REQUIRE_FALSE(std::signbit(bytecode::pow_half(-0.0)));
+        REQUIRE(bytecode::pow_half(-HUGE_VAL) == HUGE_VAL);
+        REQUIRE(std::isnan(bytecode::pow_half(-1)));
+    }
+
+    SECTION("other exponents require relaxed precision") {
+        expr = converter.convert("exp(1 + 2, 2) + exp(1 + 2, -1) + exp(1 + 2, 3) + exp(1 + 2, 0.25)");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::pow) == 4);
+        REQUIRE(expr.get_rewrites().empty());
+    }
+
+    SECTION("square and reciprocal are evaluated by pow") {
+        // pow is not correctly rounded: with glibc, x * x and 1 / x differ from it at these values
+        // (exponent is volatile, so that compiler does not fold std::pow(x, 2) into x * x)
+        postfix_converter_t var_converter =
+            test::make_plain_converter(&compile_options_t::relaxed_precision, false);
+        var_converter.add_variable("x");
+        volatile double e = -1;
+
+        double x = -0x1.ec356ba1113dfp+1;
+        REQUIRE(var_converter.convert("exp(x, -1)").evaluate_at(&x) == std::pow(x, e));
+
+        e = 2;
+        x = -0x1.f1ae83d2d7289p+2;
+        REQUIRE(var_converter.convert("exp(x, 2)").evaluate_at(&x) == std::pow(x, e));
+    }
+
+    SECTION("division by power of two becomes multiplication") {
+        expr = converter.convert("(1 + 2) / 4 + (1 + 2) / 3");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::div) == 1);
+        REQUIRE(has_rewrite(expr, "div_to_mul", "x / 4 -> x * 0.25"));
+        REQUIRE(expr.get_rewrites().size() == 1);
+        REQUIRE(expr.evaluate() == 0.75 + 1);
+    }
+
+    SECTION("can be disabled") {
+        compile_options_t options = test::plain_options();
+        options.strength_reduction = false;
+        options.relaxed_precision = true;
+        converter.set_options(options);
+
+        expr = converter.convert("exp(1 + 2, 2) / 4");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::pow) == 1);
+        REQUIRE(expr.get_rewrites().empty());
+    }
+}
+
+TEST_CASE("strength_reduction: relaxed precision", "[strength_reduction][normal]") {
+    postfix_converter_t converter = test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    postfix_expr_t expr;
+
+    SECTION("integer exponents by repeated squaring") {
+        expr = converter.convert("exp(1 + 2, 2)");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::pow) == 0);
+        REQUIRE(test::count_ops(expr.get_program(), op_t::dup) == 1);
+        REQUIRE(has_rewrite(expr, "pow_to_mul", "exp(x, 2) -> 1 multiplications"));
+        REQUIRE(expr.evaluate() == 9);
+
+        expr = converter.convert("exp(1 + 3, -1)");
+        REQUIRE(has_rewrite(expr, "pow_to_mul", "exp(x, -1) -> 1 / x"));
+        REQUIRE(expr.evaluate() == 0.25);
+
+        expr = converter.convert("exp(1 + 1, 10)");
+        // x^2, x^4, x^8, x^8 * x^2
+        REQUIRE(test::count_ops(expr.get_program(), op_t::pow) == 0);
+        REQUIRE(test::count_ops(expr.get_program(), op_t::mul) == 4);
+        REQUIRE(has_rewrite(expr, "pow_to_mul", "exp(x, 10) -> 4 multiplications"));
+        REQUIRE(expr.evaluate() == 1024);
+
+        expr = converter.convert("exp(1 + 1, -3)");
+        REQUIRE(has_rewrite(expr, "pow_to_mul", "exp(x, -3) -> 1 / (2 multiplications)"));
+        REQUIRE(expr.evaluate() == 0.125);
+
+        // too large exponent is left to pow
+        expr = converter.convert("exp(1 + 0, 100)");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::pow) == 1);
+    }
+
+    SECTION("division by any constant") {
+        expr = converter.convert("(1 + 2) / 3");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::div) == 0);
+        REQUIRE(has_rewrite(expr, "div_to_mul", "x / 3 -> x * 0.33333333333333331"));
+        REQUIRE(close(expr.evaluate(), 1));
+
+        // reciprocal of zero does not exist
+        expr = converter.convert("(1 + 2) / 0");
+        REQUIRE(test::count_ops(expr.get_program(), op_t::div) == 1);
+        REQUIRE(expr.evaluate() == HUGE_VAL);
+    }
+}
+
+TEST_CASE("strength_reduction: differential test", "[strength_reduction][differential]") {
+    postfix_converter_t plain_converter =
+        test::make_plain_converter(&compile_options_t::strength_reduction, false);
+    postfix_converter_t strict_converter =
+        test::make_plain_converter(&compile_options_t::relaxed_precision, false);
+    postfix_converter_t relaxed_converter =
+        test::make_plain_converter(&compile_options_t::relaxed_precision, true);
+    test::expr_generator_t gen(909);
+
+    const backend_t backends[] = {
+        backend_t::switch_dispatch,
+        backend_t::threaded,
+        backend_t::register_vm,
+        backend_t::jit
+    };
+
+    for(int i = 0; i < 500; ++i) {
+        std::string in = gen.generate(6);
+        double expected = plain_converter.convert(in).evaluate();
+        postfix_expr_t strict = strict_converter.convert(in);
+        postfix_expr_t relaxed = relaxed_converter.convert(in);
+
+        INFO(in);
+        for(backend_t backend : backends) {
+            strict.set_backend(backend);
+            REQUIRE(test::same_value(strict.evaluate(), expected));
+
+            relaxed.set_backend(backend);
+            if(std::isfinite(expected))
+                REQUIRE(close(relaxed.evaluate(), expected));
+        }
+    }
+}
+
+} // namespace postfix::optimizer
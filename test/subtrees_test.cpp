@@ -0,0 +1,116 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "subtrees.h"
+
+#include "expr_generator.h"
+
+#include <string>
+
+namespace postfix::parallel {
+
+namespace {
+
+// converter, which splits expressions into subtrees of at least [task_size] instructions
+postfix_converter_t make_converter(int task_size) {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    compile_options_t options = converter.get_options();
+    options.parallel_task_size = task_size;
+    converter.set_options(options);
+    converter.add_variable("x");
+
+    return converter;
+}
+
+} // namespace
+
+TEST_CASE("subtrees: splitting", "[subtrees][normal]") {
+    thread_pool_t pool(4);
+    double x = 1.5;
+
+    SECTION("small expression stays serial") {
+        postfix_converter_t converter = make_converter(subtree_program_t::default_min_task_size);
+        postfix_expr_t expr = converter.convert("(1 + x) * (2 + x)");
+
+        REQUIRE_FALSE(subtree_program_t(expr.get_program()).split());
+        REQUIRE(expr.evaluate_parallel(pool, &x) == expr.evaluate_at(&x));
+    }
+
+    SECTION("operands of top-level operator and function arguments") {
+        postfix_converter_t converter = make_converter(4);
+        postfix_expr_t expr = converter.convert(
+            "exp(x * 2 + x / 3 - x * 0.5, 1 + x * 0.25 + x / 7) + (x - 1) * (x - 2) * (x - 3) * (x - 4)"
+        );
+
+        subtree_program_t split(expr.get_program(), 4);
+        REQUIRE(split.split());
+        REQUIRE(split.get_num_tasks() >= 3);
+        REQUIRE(split.get_combine().get_num_variables() == 1 + split.get_num_tasks());
+
+        // tasks and combining program cover the whole program
+        int size = split.get_combine().get_code().size() - split.get_num_tasks();
+        for(int k = 0; k < split.get_num_tasks(); ++k)
+            size += split.get_task(k).get_code().size();
+        REQUIRE(size == expr.get_program().get_code().size());
+
+        REQUIRE(split.run(pool, &x) == expr.evaluate_at(&x));
+        REQUIRE(expr.evaluate_parallel(pool, &x) == expr.evaluate_at(&x));
+    }
+
+    SECTION("[max_tasks] limits splitting") {
+        postfix_converter_t converter = make_converter(4);
+        postfix_expr_t expr = converter.convert("(x + 1) * (x + 2) - (x + 3) * (x + 4)");
+
+        // x + 1 is the smallest task: load_var, add_imm
+        REQUIRE(subtree_program_t(expr.get_program(), 2, 2).get_num_tasks() == 2);
+        REQUIRE(subtree_program_t(expr.get_program(), 2, 3).get_num_tasks() == 3);
+        REQUIRE(subtree_program_t(expr.get_program(), 2, 100).get_num_tasks() == 4);
+    }
+
+    SECTION("subtrees, sharing common subexpressions, are not separated") {
+        postfix_converter_t converter = make_converter(4);
+        std::string shared = "(x * 3 + 1)";
+        postfix_expr_t expr = converter.convert(
+            "(" + shared + " * 2 + 5) * (" + shared + " / 4 - 6) + (x * 7 - 8) * (x / 9 + 10)"
+        );
+
+        subtree_program_t split(expr.get_program(), 3);
+        REQUIRE(split.split());
+        for(int k = 0; k < split.get_num_tasks(); ++k) {
+            const bytecode::program_t& task = split.get_task(k);
+            for(int i = 0; i < task.get_code().size(); ++i)
+                REQUIRE(task.get_code()[i].op != bytecode::opcode_t::load_tmp);
+        }
+        REQUIRE(split.run(pool, &x) == expr.evaluate_at(&x));
+    }
+
+    SECTION("values of variables are required") {
+        postfix_converter_t converter = make_converter(4);
+        postfix_expr_t expr = converter.convert("(x + 1) * (x + 2) - (x + 3) * (x + 4)");
+
+        REQUIRE_THROWS_AS(expr.evaluate_parallel(pool), std::logic_error);
+    }
+}
+
+TEST_CASE("subtrees: differential test against serial evaluation", "[subtrees][differential]") {
+    postfix_converter_t converter = make_converter(16);
+    test::expr_generator_t gen(1919);
+
+    const int worker_counts[] = { 1, 3 };
+    for(int num_workers : worker_counts) {
+        thread_pool_t pool(num_workers);
+
+        for(int i = 0; i < 300; ++i) {
+            // variable keeps constant folding away, repetition gives common subexpressions
+            std::string half = gen.generate(7);
+            std::string in = "(" + half + ") * x - exp(" + half + ", 2) / (" + gen.generate(7) + ")";
+            postfix_expr_t expr = converter.convert(in);
+
+            double x = 0.75;
+            INFO(in);
+            REQUIRE(test::same_value(expr.evaluate_parallel(pool, &x), expr.evaluate_at(&x)));
+        }
+    }
+}
+
+} // namespace postfix::parallel
@@ -0,0 +1,141 @@
+#include <catch2/catch_all.hpp>
+
+#include "postfix.h"
+#include "superinstructions.h"
+
+#include "expr_generator.h"
+
+namespace postfix::bytecode {
+
+// opcodes of program, in order
+static util::vector<opcode_t> get_opcodes(const program_t& prog) {
+    util::vector<opcode_t> res;
+    for(int i = 0; i < prog.get_code().size(); ++i)
+        res.push_back(prog.get_code()[i].op);
+
+    return res;
+}
+
+static postfix_converter_t make_converter(const superinstruction_set_t& set) {
+    postfix_converter_t converter;
+    compile_options_t options;
+    options.constant_folding = false;
+    options.superinstructions = set;
+    options.scheduling = false; /*keep source order of operands*/
+    converter.set_options(options);
+
+    return converter;
+}
+
+TEST_CASE("superinstructions: fusion", "[superinstructions][normal]") {
+    postfix_converter_t converter = make_converter(superinstruction_set_t::all());
+    postfix_expr_t expr;
+    typedef opcode_t op;
+
+    SECTION("number after operator becomes immediate") {
+        expr = converter.convert("2 * 3 + 4");
+        REQUIRE(get_opcodes(expr.get_program()) ==
+            util::vector<op>{ op::push_const, op::mul_imm, op::add_imm });
+        REQUIRE(expr.evaluate() == 10);
+    }
+
+    SECTION("negated constant") {
+        expr = converter.convert("-5 - 3");
+        REQUIRE(get_opcodes(expr.get_program()) ==
+            util::vector<op>{ op::push_const, op::sub_imm });
+        REQUIRE(expr.evaluate() == -8);
+
+        expr = converter.convert("-(-(5))");
+        REQUIRE(get_opcodes(expr.get_program()) == util::vector<op>{ op::push_const });
+        REQUIRE(expr.evaluate() == 5);
+    }
+
+    SECTION("multiply-add by immediate") {
+        expr = converter.convert("1 + 2 * 3");
+        REQUIRE(get_opcodes(expr.get_program()) ==
+            util::vector<op>{ op::push_const, op::push_const, op::mul_imm_add });
+        REQUIRE(expr.evaluate() == 7);
+
+        expr = converter.convert("1 - 2 * 3");
+        REQUIRE(get_opcodes(expr.get_program()) ==
+            util::vector<op>{ op::push_const, op::push_const, op::mul_imm_sub });
+        REQUIRE(expr.evaluate() == -5);
+    }
+
+    SECTION("disabled superinstructions are not emitted") {
+        superinstruction_set_t set;
+        set.enable(superinstruction_t::mul_imm);
+        converter = make_converter(set);
+
+        expr = converter.convert("1 + 2 * 3");
+        REQUIRE(get_opcodes(expr.get_program()) ==
+            util::vector<op>{ op::push_const, op::push_const, op::mul_imm, op::add });
+    }
+}
+
+TEST_CASE("superinstructions: fused programs match unfused ones", "[superinstructions][differential]") {
+    postfix_converter_t
+        fused_conv = make_converter(superinstruction_set_t::all()),
+        plain_conv = make_converter(superinstruction_set_t::none());
+    test::expr_generator_t gen(7);
+
+    const backend_t backends[] = {
+        backend_t::switch_dispatch, backend_t::threaded, backend_t::register_vm
+    };
+
+    for(int i = 0; i < 300; ++i) {
+        std::string in = gen.generate(5);
+        postfix_expr_t fused = fused_conv.convert(in);
+        double expected = plain_conv.convert(in).evaluate();
+
+        INFO(in);
+        REQUIRE(fused.get_program().get_code().size() <=
+                plain_conv.convert(in).get_program().get_code().size());
+
+        for(backend_t backend : backends) {
+            fused.set_backend(backend);
+            REQUIRE(test::same_value(fused.evaluate(), expected));
+        }
+    }
+}
+
+TEST_CASE("superinstructions: set derived from corpus", "[superinstructions][profiler]") {
+    postfix_converter_t converter = make_converter(superinstruction_set_t::none());
+    ngram_profiler_t profiler;
+
+    // corpus is dominated by multiplication and addition of numbers
+    const char *corpus[] = {
+        "(1 + 2) * 3 - 4",
+        "(5 + 6) * 7 - 8 * 9",
+        "(1 + 3) * 2",
+        "exp(2, 3) * 4 - 1"
+    };
+    for(const char *in : corpus)
+        profiler.record(converter.convert(in).get_program());
+
+    typedef opcode_t op;
+    REQUIRE(profiler.get_count(util::vector<op>{ op::push_const, op::mul }) == 5);
+    REQUIRE(profiler.get_count(util::vector<op>{ op::push_const, op::sub }) == 2);
+    REQUIRE(profiler.get_count(util::vector<op>{ op::push_const, op::div }) == 0);
+
+    // "push_const mul" and "push_const push_const" are the most frequent
+    util::vector<ngram_profiler_t::ngram_count_t> top = profiler.top(2);
+    REQUIRE(top.size() == 2);
+    REQUIRE(top[0].count == 5);
+    REQUIRE(top[1].count == 5);
+    REQUIRE(ngram_profiler_t::to_string(top[0].ngram) == "push_const mul");
+
+    REQUIRE(profiler.get_count(util::vector<op>{ op::push_const, op::add }) == 3);
+
+    // 2 most frequent: mul_imm (5), add_imm (3)
+    superinstruction_set_t set = profiler.select(2);
+    REQUIRE(set.contains(superinstruction_t::mul_imm));
+    REQUIRE(set.contains(superinstruction_t::add_imm));
+    REQUIRE_FALSE(set.contains(superinstruction_t::sub_imm));
+    REQUIRE_FALSE(set.contains(superinstruction_t::div_imm));
+
+    // patterns, which are too rare, are skipped
+    REQUIRE(profiler.select(8, 0.99).empty());
+}
+
+} // namespace postfix::bytecode
@@ -0,0 +1,230 @@
+#include <catch2/catch_all.hpp>
+
+#include "parallel.h"
+#include "thread_pool.h"
+
+#include "expr_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace postfix::parallel {
+
+namespace {
+
+// programs have the same instructions and constants
+bool same_program(const bytecode::program_t& a, const bytecode::program_t& b) {
+    const util::vector<bytecode::instruction_t>& code_a = a.get_code();
+    const util::vector<bytecode::instruction_t>& code_b = b.get_code();
+    if(code_a.size() != code_b.size() || a.get_constants().size() != b.get_constants().size())
+        return false;
+
+    for(int i = 0; i < code_a.size(); ++i)
+        if(code_a[i].op != code_b[i].op || code_a[i].arg != code_b[i].arg)
+            return false;
+
+    return std::equal(a.get_constants().begin(), a.get_constants().end(), b.get_constants().begin());
+}
+
+// message of exception, thrown by [func], or empty string
+template<typename Func>
+std::string error_of(Func func) {
+    try {
+        func();
+    } catch(const std::exception& e) {
+        return e.what();
+    }
+    return "";
+}
+
+} // namespace
+
+TEST_CASE("thread_pool: parallel_for", "[thread_pool][normal]") {
+    const int worker_counts[] = { 1, 2, 4, 8 };
+
+    for(int num_workers : worker_counts) {
+        thread_pool_t pool(num_workers);
+        REQUIRE(pool.get_num_workers() == num_workers);
+        INFO(num_workers);
+
+        SECTION("every task runs once") {
+            const int num_tasks = 10000;
+            util::vector<int> runs(num_tasks, 0);
+            std::atomic<int> bad_worker(0);
+
+            pool.parallel_for(num_tasks, [&](int worker, int task) {
+                if(worker < 0 || worker >= num_workers)
+                    ++bad_worker;
+                ++runs[task];
+            });
+
+            REQUIRE(bad_worker == 0);
+            for(int i = 0; i < num_tasks; ++i)
+                REQUIRE(runs[i] == 1);
+        }
+
+        SECTION("pool is reused by consecutive loops") {
+            for(int k = 0; k < 50; ++k) {
+                std::atomic<long> sum(0);
+                pool.parallel_for(k * 7, [&](int, int task) { sum += task; }, 3);
+                REQUIRE(sum == (long) k * 7 * (k * 7 - 1) / 2);
+            }
+        }
+
+        SECTION("skewed costs") {
+            // the first tasks are much more expensive than the rest
+            const int num_tasks = 256;
+            util::vector<double> results(num_tasks, 0);
+
+            pool.parallel_for(num_tasks, [&](int, int task) {
+                int iters = task < 4 ? 200000 : 100;
+                double x = 0;
+                for(int i = 0; i < iters; ++i)
+                    x += 1.0 / (i + task + 1);
+                results[task] = x;
+            });
+
+            for(int i = 0; i < num_tasks; ++i)
+                REQUIRE(results[i] > 0);
+        }
+
+        SECTION("exception of the lowest task is rethrown, other tasks run") {
+            const int num_tasks = 1000;
+            std::atomic<int> done(0);
+
+            try {
+                pool.parallel_for(num_tasks, [&](int, int task) {
+                    if(task % 100 == 37)
+                        throw std::runtime_error(std::to_string(task));
+                    ++done;
+                });
+                FAIL("exception is not rethrown");
+            } catch(const std::runtime_error& e) {
+                REQUIRE(std::string(e.what()) == "37");
+            }
+            REQUIRE(done == num_tasks - 10);
+        }
+
+        SECTION("empty loop") {
+            pool.parallel_for(0, [&](int, int) { FAIL("task of empty loop"); });
+        }
+    }
+}
+
+TEST_CASE("thread_pool: convert_and_evaluate", "[thread_pool][normal]") {
+    postfix_converter_t converter;
+    test::expr_generator_t gen(1818);
+
+    // lengths are highly skewed
+    util::vector<std::string> inputs;
+    for(int i = 0; i < 2000; ++i)
+        inputs.push_back(gen.generate(i % 50 == 0 ? 12 : 3));
+
+    util::vector<double> expected;
+    for(int i = 0; i < inputs.size(); ++i)
+        expected.push_back(converter.convert(inputs[i]).evaluate());
+
+    thread_pool_t pool(4);
+    util::vector<double> results(inputs.size());
+
+    SECTION("results are in input order") {
+        convert_and_evaluate(pool, converter, inputs.begin(), inputs.size(), results.begin());
+        for(int i = 0; i < inputs.size(); ++i)
+            REQUIRE(test::same_value(results[i], expected[i]));
+    }
+
+    SECTION("variables") {
+        converter.add_variable("x");
+        inputs[10] = "x * 2";
+
+        double x = 21;
+        convert_and_evaluate(pool, converter, inputs.begin(), inputs.size(), results.begin(), &x);
+        REQUIRE(results[10] == 42);
+        REQUIRE(test::same_value(results[11], expected[11]));
+    }
+
+    SECTION("error of the first failed input is thrown") {
+        inputs[500] = "1 + + 2";
+        inputs[100] = "exp((), 2)";
+
+        REQUIRE_THROWS_AS(
+            convert_and_evaluate(pool, converter, inputs.begin(), inputs.size(), results.begin()),
+            std::domain_error
+        );
+    }
+}
+
+TEST_CASE("thread_pool: convert_parallel", "[thread_pool][normal]") {
+    postfix_converter_t converter = test::make_unfolded_converter();
+    converter.add_variable("x");
+    test::expr_generator_t gen(2020);
+
+    const int worker_counts[] = { 1, 3 };
+    for(int num_workers : worker_counts) {
+        thread_pool_t pool(num_workers);
+        INFO(num_workers);
+
+        SECTION("postfix is identical to serial conversion") {
+            for(int i = 0; i < 50; ++i) {
+                // terms of top-level sum, some of them signed or without spaces around operator
+                std::string in = gen.generate(4);
+                for(int k = 0; k < 30; ++k) {
+                    static const char *ops[] = { " + ", " - ", "+", "-", " -  ", "\t+ " };
+                    std::string term = k % 7 == 3 ? "(-x * " + gen.generate(3) + ")" : gen.generate(4);
+                    in += ops[k % 6] + term;
+                }
+
+                postfix_expr_t serial = converter.convert(in);
+                postfix_expr_t parallel = converter.convert_parallel(in, pool, 16);
+
+                double x = 1.25;
+                INFO(in);
+                REQUIRE(same_program(parallel.get_program(), serial.get_program()));
+                REQUIRE(test::same_value(parallel.evaluate_at(&x), serial.evaluate_at(&x)));
+            }
+        }
+
+        SECTION("inputs, which can not be split") {
+            const char *inputs[] = {
+                "(1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12)",     /*no top-level operator*/
+                "exp(1 + 2 + 3 + 4 + 5, 2) * exp(6 + 7 + 8 + 9 + 10, 3)",  /*top-level operator is * */
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8",                           /*too small to split*/
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10) + (11 + 12 + 13 + 14 + 15 + 16 + 17",
+                                                                            /*parenthesis closes outer one*/
+            };
+
+            for(const char *in : inputs) {
+                INFO(in);
+                REQUIRE(same_program(
+                    converter.convert_parallel(in, pool, 16).get_program(),
+                    converter.convert(in).get_program()
+                ));
+            }
+        }
+
+        SECTION("invalid inputs give the same error") {
+            const char *inputs[] = {
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 + 13 + 14 + 15 + 16 + 17 + 18 + +19",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 - -13 + 14 + 15 + 16 + 17 + 18",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 + 13 * + 14 + 15 + 16 + 17 + 18",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11, 12 + 13 + 14 + 15 + 16 + 17 + 18",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + (12 + 13 + 14 + 15 + 16 + 17 + 18",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + 11 + 12 + 13 + 14 + 15 + 16 + 17 + 18 + ",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + exp + 12 + 13 + 14 + 15 + 16 + 17 + 18",
+                "1 + 2 + 3 + 4 + 5 + 6 + 7 + 8 + 9 + 10 + y + 12 + 13 + 14 + 15 + 16 + 17 + 18",
+            };
+
+            for(const char *in : inputs) {
+                INFO(in);
+                std::string expected = error_of([&] { converter.convert(in); });
+                REQUIRE(!expected.empty());
+                REQUIRE(error_of([&] { converter.convert_parallel(in, pool, 16); }) == expected);
+            }
+        }
+    }
+}
+
+} // namespace postfix::parallel